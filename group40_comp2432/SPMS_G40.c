@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // MAP_ANONYMOUS under -std=c99
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,19 +6,63 @@
 #include <sys/wait.h>
 #include <stdbool.h> 
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 // Constants
 #define INF 1000000000
+#define MINUTES_PER_DAY 1440
 #define MAX_LINE 256
-#define MAX_BOOKINGS 100
+#define INITIAL_BOOKING_CAPACITY 64
 #define MAX_NAME_LEN 50
-#define NUM_OF_MEMBER 5
+#define NUM_DEFAULT_MEMBERS 5 // member_A ... member_E, always listed in the report even without bookings
+#define INITIAL_MEMBER_HASH_SIZE 64
 #define MAX_DATE_LEN 20
 #define MAX_FACILITIES 6
 #define MAX_FACILITY_NAME_LENGTH 20
-#define TOTAL_PARKING_SLOTS 10
-#define MAX_COMMAND_LENGTH 256
+#define DEFAULT_PARKING_SLOTS 10
+#define DEFAULT_FACILITY_UNITS 3
+#define MAX_BOOKING_HOURS 72 // Longest booking accepted, so end times stay far from int overflow and fit the report
+#define MAX_YEAR 2999 // Last year accepted, so minute timestamps stay below INF (the never-free bay time)
+#define MAX_SITE_FACILITIES 32
+#define FACILITY_HASH_SIZE 64 // Power of two, at least twice MAX_SITE_FACILITIES
+#define DEFAULT_SITE_CONFIG "site_G40.cfg"
+#define INPUT_BUFFER_SIZE (1 << 20) // Commands are read in chunks this big and tokenized in place
+#define PARALLEL_BATCH_MIN_BYTES (4L << 20) // Smaller batch files are parsed on the main process only
+#define BATCH_WINDOW_BYTES (64L << 20)      // Parallel parsing works through big batch files one window at a time
+#define MAX_PARSE_WORKERS 32
 #define NUM_ALGORITHMS 3
+#define PARALLEL_DAYS_MIN_BOOKINGS 50000 // Below this, scheduling days on forked workers costs more than it saves
+#define MAX_DAY_WORKERS 32
+#define TIMELINE_LEAVES 2048 // Power of two > MINUTES_PER_DAY: the facility timeline covers a day and the minute after it
+#define STAT_SAMPLE_EVERY 16 // Per booking hot paths time one call in this many and scale up; calls are exact
+#define REPORT_BUFFER_SIZE (1 << 20) // printBookings formats its tables into a buffer this big and writes it out whole
+#define SNAPSHOT_MAGIC "SPMSSNAP" // First 8 bytes of a saveSnapshot file
+#define SNAPSHOT_VERSION 1         // Bump whenever the file layout or a stored struct changes
+#define SNAPSHOT_ALIGN 64          // Every section starts on a cache line, so the columns can be used in place
+#define WAL_MAGIC "SPMSWAL1"       // First 8 bytes of a -wal file
+#define WAL_VERSION 2              // Bump whenever WalRecord or a struct inside it changes
+#define WAL_GROUP_RECORDS 4096     // fdatasync the write-ahead log after this many new records...
+#define WAL_SYNC_INTERVAL_MS 10    // ...or once the oldest unsynced record is this old, whichever comes first
+#define DAEMON_MAX_EVENTS 64        // epoll events handled per wakeup
+#define DAEMON_MAX_REQUEST (1 << 16) // A client sending a longer line than this is disconnected
+#define DAEMON_SEND_TIMEOUT_SEC 5   // A client that stops reading its replies for this long is dropped
+#define DAEMON_END_OF_REPLY ".\n"   // Line that ends the reply to every command in daemon mode
+#define IPC_BUFFER_SIZE 65536 // Debug text IPC: scheduler -> reporter pipe writes are batched into buffers this big
+#define IPC_LINE_SIZE (4 * MAX_NAME_LEN + MAX_DATE_LEN + MAX_FACILITIES * MAX_FACILITY_NAME_LENGTH + 64) // Longest debug text record line
+// Build with -DDEBUG_TEXT_IPC to stream the old human readable text lines over the pipe instead of shared memory
+// Build with -DBENCHMARK to print phase timings to stderr for benchmark_G40 (see bench_report)
 
 // Enums
 typedef enum {
@@ -28,96 +73,606 @@ typedef enum {
     CMD_BOOK_ESSENTIALS
 } CommandType;
 
+typedef enum {
+    PARSE_OK,
+    PARSE_BAD_FORMAT,
+    PARSE_BAD_TIME,
+    PARSE_TOO_MANY_FACILITIES,
+    PARSE_NEW_FACILITY  // Only without interning: the site does not know one of the facility names yet
+} ParseResult;
+
+typedef enum {
+    BATCH_LINE_BLANK,
+    BATCH_LINE_BOOKING, // Parsed by a worker, the main process only interns a new member and appends it
+    BATCH_LINE_REPLAY   // Anything else: the main process runs the line itself, in file order
+} BatchLineKind;
+
+typedef enum {
+    SORT_BY_ARRIVAL,
+    SORT_BY_PRIORITY,
+    SORT_BY_START_TIME
+} SortOrder;
+
+// Index into schedule_caches, same order as printBookings -all prints them
+typedef enum {
+    ALGORITHM_FCFS,
+    ALGORITHM_PRIO,
+    ALGORITHM_SJF
+} Algorithm;
+
+typedef enum {
+    SLOT_FIRST_FIT, // Lowest numbered bay that is free at the start time
+    SLOT_BEST_FIT   // Bay that became free closest to the start time (smallest idle gap)
+} SlotPolicy;
+
+// Hot paths timed for printStats, same order as stat_names
+typedef enum {
+    STAT_PARSE,            // parse_booking: one booking command
+    STAT_SORT,             // build_calendar_index: ordering one scheduling pass
+    STAT_SLOT_ALLOCATION,  // slot_allocator_find / slot_allocator_assign
+    STAT_FACILITY_RESERVE, // check_and_reserve_facilities
+    STAT_PIPE_WRITE,       // pipe_write: scheduler -> reporter pipe only, not the report going to stdout
+    STAT_CHILD_PARSE,      // Reporter sorting one decision into accepted / rejected
+    STAT_WAL_SYNC,         // wal_sync: write out and fdatasync one group of write-ahead log records
+    NUM_STATS
+} StatCounter;
+
+typedef enum {
+    RECORD_SCHEDULED,
+    RECORD_REJECTED
+} RecordStatus;
+
 // Structures
+// A booking's strings as typed; only the report and the debug text IPC read them
 typedef struct {
-    int id;
     char client[MAX_NAME_LEN];
     char type[MAX_NAME_LEN];
     char date[MAX_DATE_LEN];
     char time[MAX_NAME_LEN];
+} BookingText;
+
+typedef struct {
+    unsigned char ids[MAX_FACILITIES]; // Site facility ids in the order they were requested
+    unsigned char count;
+} FacilityList;
+
+// One parsed booking command, before append_booking files it into the booking table
+typedef struct {
+    BookingText text;
     float duration;
-    char facilities[MAX_FACILITIES][MAX_FACILITY_NAME_LENGTH];
-    int facility_count;
+    int start_minute; // Minutes since 1970-01-01 00:00, computed once when the booking is parsed
+    int end_minute;
+    int member;
+    unsigned char type;
+    unsigned char priority;
+    FacilityList facilities;
+    unsigned int facility_mask;
 } Booking;
 
+// All bookings, one column per field; a booking's id is its index. The sort and the schedulers only read
+// the small numeric columns, so their working set stays in cache while the strings sit in the cold column.
+typedef struct {
+    int* start_minute;
+    int* end_minute;
+    float* duration;             // Hours
+    int* member;                 // Member registry id
+    unsigned char* type;         // CommandType
+    unsigned char* priority;     // get_priority of the type string, lower is scheduled first
+    unsigned int* facility_mask; // Bit i set when facility id i is requested
+    FacilityList* facilities;
+    BookingText* text;           // Cold
+
+    void* mapping;      // Set while the columns point into a loaded snapshot instead of the heap
+    size_t mapped_size;
+} BookingTable;
+
+// Every column of the booking table with its element type, in snapshot file order
+#define BOOKING_COLUMNS(X) \
+    X(start_minute, int) \
+    X(end_minute, int) \
+    X(duration, float) \
+    X(member, int) \
+    X(type, unsigned char) \
+    X(priority, unsigned char) \
+    X(facility_mask, unsigned int) \
+    X(facilities, FacilityList) \
+    X(text, BookingText)
+#define COLUMN_INDEX(name, type) COLUMN_##name,
+typedef enum { BOOKING_COLUMNS(COLUMN_INDEX) NUM_BOOKING_COLUMNS } BookingColumn;
+#undef COLUMN_INDEX
+
+// saveSnapshot file: this header, then the site's facility names, the member names and one section per
+// booking column, each SNAPSHOT_ALIGN aligned. The checksum covers every section in that order.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;          // The sizes below catch a file written by a build with other limits
+    uint32_t name_length;
+    uint32_t facility_name_length;
+    uint32_t text_size;
+    int32_t booking_count;
+    int32_t member_count;
+    int32_t facility_count;
+    uint64_t checksum;
+    uint64_t file_size;
+    uint64_t facility_offset;
+    uint64_t member_offset;
+    uint64_t column_offset[NUM_BOOKING_COLUMNS];
+} SnapshotHeader;
+
+typedef enum {
+    WAL_RECORD_BOOKING = 1, // A booking entered the table
+    WAL_RECORD_SNAPSHOT     // loadSnapshot replaced the table: the log starts over from a snapshot of its own
+} WalRecordKind;
+
+// -wal file: this header, then one fixed-size WalRecord per change to the booking table
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size; // Catches a file written by a build with other limits
+} WalHeader;
+
+typedef struct {
+    uint32_t kind;     // WalRecordKind
+    uint32_t reserved;
+    uint64_t checksum; // Of everything after this field, so a record torn by a crash is recognised
+    union {
+        // Member and facility ids are looked up again from the names on replay
+        struct {
+            Booking booking;
+            char facility_names[MAX_FACILITIES][MAX_FACILITY_NAME_LENGTH];
+        } add;
+        // The log's own snapshot is "<log>.<sequence>.snap"; its size and checksum catch a changed file
+        struct {
+            uint32_t sequence;
+            uint32_t reserved;
+            uint64_t size;
+            uint64_t checksum;
+        } snapshot;
+    } data;
+} WalRecord;
+
+// Group commit: records collect in buffer and are written out when the input goes idle or the group is full,
+// and fdatasync runs once per group instead of once per booking
+typedef struct {
+    int fd;                   // -1 unless the program was started with -wal
+    char path[MAX_LINE];
+    uint32_t checkpoint;      // Sequence number of the log's own snapshot, 0 before the first loadSnapshot
+    WalRecord* buffer;        // Records not written to fd yet
+    int buffered;
+    int unsynced;             // Records since the last fdatasync, buffered ones included
+    long long first_unsynced; // stat_clock() when the oldest of them was appended
+} WriteAheadLog;
+
+// One connection in daemon mode: bytes received that do not form a complete command line yet
+typedef struct {
+    int fd;
+    char* buffer;
+    int used;
+    int capacity;
+} DaemonClient;
+
 typedef struct {
     int id;
     int parking_slot;
-    int start_time;
+    int start_time; // Minutes since 1970-01-01 00:00
     int end_time;
-    char status[MAX_NAME_LEN];
+    RecordStatus status;
 } Schedule;
 
-// Global Variables
-Schedule accepted[NUM_OF_MEMBER][MAX_BOOKINGS];
-int accepted_count[NUM_OF_MEMBER] = {0};
+// Fixed-size binary record the scheduler writes for every booking into the shared schedule mapping.
+// The child is forked from the parent, so it looks the booking strings up in its own copy of bookings.
+typedef struct {
+    int id;
+    int parking_slot;
+    int start_time;
+    int end_time;
+    unsigned int facility_mask;
+    int status; // RecordStatus
+} ScheduleRecord;
+
+// Scheduler -> printBookings handoff. Records go into an anonymous MAP_SHARED mapping created before fork,
+// and only the final record count crosses the pipe as the completion notice.
+typedef struct {
+    int summary[4];            // Summary row of the run, filled in by forked -all workers (see SchedulerContext)
+    int kept;                  // Leading records the scheduler took from the cache, set before the completion notice
+    ScheduleRecord records[];  // One record per booking
+} ScheduleMapping;
+
+typedef struct {
+    int pipe_fd[2];
+    ScheduleMapping* shared;
+    size_t mapped_size;
+} ScheduleChannel;
+
+typedef struct {
+    int fd;
+    ScheduleRecord* records;
+    int count;
+#ifdef DEBUG_TEXT_IPC
+    size_t used;
+    char buffer[IPC_BUFFER_SIZE]; // Batches debug text lines so the pipe sees a few large writes
+#endif
+} RecordWriter;
+
+// Parking slot allocator: a segment tree over the bays keeping the min "free at" time of each subtree (first fit),
+// and a treap of the bays ordered by free at time, ties by bay number descending (best fit)
+typedef struct {
+    int bay_count;
+    int leaves;     // Power of two >= bay_count, padding leaves are never free
+    int* min_free;  // Node i covers children 2i and 2i+1, leaves start at index `leaves`
+    int* left;      // Treap children of each bay, -1 for none; a bay's priority is a fixed hash of its number
+    int* right;
+    int root;
+} SlotAllocator;
+
+// Facility timeline: units of each facility in use per minute of the day being scheduled, one segment tree per
+// facility with range add and range max over the minutes [origin, origin + TIMELINE_LEAVES). Every booking decided
+// on a day starts on or before it, so use after midnight can only fall: the minute after midnight stands for the
+// rest of a booking's time. Accepted bookings still running at midnight are carried into the next day's trees.
+typedef struct {
+    int origin;           // Midnight of the day being scheduled, the minute of leaf 0
+    int facility_count;   // Trees allocated
+    int* used;            // Facility f's tree starts at f * 2 * TIMELINE_LEAVES: node i = most units in use under it
+    int* added;           // Same layout: units added to node i's whole range, never pushed down to the children
+    unsigned int cleared; // Bit f set once facility f's tree has been zeroed for the current day
+    int* carried;         // Accepted bookings that may still hold facilities after the current day
+    int carried_count;
+    int carried_capacity;
+} FacilityTimeline;
+
+// Site configuration: bay count and facility inventory, loaded once at startup
+typedef struct {
+    int bay_count;
+    int facility_count;
+    char facility_names[MAX_SITE_FACILITIES][MAX_FACILITY_NAME_LENGTH];
+    int facility_capacity[MAX_SITE_FACILITIES];
+    int facility_pair[MAX_SITE_FACILITIES];      // Facility reserved together with this one, -1 if none
+    signed char facility_lookup[FACILITY_HASH_SIZE]; // Open addressing table of name -> facility id, -1 = empty
+} SiteConfig;
+
+// Member registry: client names interned into dense ids, in order of first appearance
+typedef struct {
+    int count;
+    int capacity;
+    char (*names)[MAX_NAME_LEN];
+    int* lookup;     // Open addressing table of name -> member id, -1 = empty
+    int lookup_size; // Power of two, kept at least twice count
+    int generation;  // Bumped by init_members, ids handed out before that mean nothing any more
+} MemberRegistry;
+
+// Calendar index: the scheduling order regrouped by day (CSR layout)
+typedef struct {
+    int day_count;
+    int* days;         // Days since 1970-01-01, ascending
+    int* offsets;      // Day d holds entries[offsets[d] .. offsets[d + 1])
+    bool* independent; // No booking from an earlier day is still running at this day's midnight
+    int* entries;      // Booking indices, in the scheduler's order within each day
+} CalendarIndex;
+
+// Precomputed sort key for one booking, so the comparison never re-parses strings
+typedef struct {
+    int primary;
+    int secondary;
+    int index;
+} SortKey;
+
+// Bays and facilities one day of the FCFS schedule leaves for a booking decided after all of that day's bookings
+typedef struct {
+    int day;                            // Days since 1970-01-01
+    int busy_first;                     // Bays still busy after midnight are busy_until[busy_first .. busy_last)
+    int busy_last;
+    int steps[MAX_SITE_FACILITIES + 1]; // Facility f's steps are [steps[f], steps[f + 1])
+} OccupancyDay;
+
+// The FCFS scheduler's state at the end of every scheduled day, for queryAvailability: the free_at of each bay
+// still busy after the day's midnight (every other bay is free for the whole day), and the units of each
+// facility in use over the day's timeline as a step function with a max tree over its steps.
+// Updated from the first changed day on whenever the FCFS cache is; a query first brings that cache up to date.
+typedef struct {
+    OccupancyDay* days; // Ascending, a day holding no booking and carrying none over is left out
+    int day_count;
+    int day_capacity;
+    int* busy_until;     // free_at of the busy bays, ascending within a day
+    int busy_count;
+    int busy_capacity;
+    int* step_time;      // Step k holds step_in_use[k] units from step_time[k] on, ascending within a facility's day
+    int* step_in_use;
+    int step_count;
+    int step_capacity;
+    int* step_max;       // Steps [a, b) have their max tree at step_max + 2 * a, leaf k at index (b - a) + k
+    int max_capacity;
+    SortKey* scratch;    // Sort buffer for the busy bays and the facility events of one day
+    int scratch_capacity;
+} OccupancyIndex;
+
+// The last schedule one algorithm produced, so the next printBookings only redoes the days new bookings touch
+typedef struct {
+    int booking_count;        // Bookings [0, booking_count) have a record
+    ScheduleRecord* records;  // In calendar order (days ascending)
+    int* latest_end;          // latest_end[i] = latest end_time among records[0 .. i)
+    int capacity;
+    OccupancyIndex* occupancy; // Kept in step with the records unless NULL
+} ScheduleCache;
+
+// SJF ready queue: binary min-heap of booking indices, shortest duration first, then arrival
+typedef struct {
+    int* items;
+    int count;
+} ReadyQueue;
+
+// Everything one scheduling run mutates. Each run gets its own context, so several runs (algorithms, sites,
+// what-if scenarios) can exist in one process. Contexts are pooled: reuse keeps the arrays and only resets counts.
+typedef struct {
+    FacilityTimeline facilities; // Facility units reserved over time, against site.facility_capacity
+
+    int summary[4]; // Metrics: [0] = Total bookings, [1] = Assigned, [2] = Rejected, [3] = Invalid
+
+    // Filled by the printBookings child (see classify_records): each member's decisions stored back to back,
+    // member m's accepted ones are accepted[accepted_offsets[m] .. accepted_offsets[m + 1])
+    Schedule* accepted;
+    int* accepted_offsets;
+    int accepted_capacity;
+
+    Schedule* rejected;
+    int* rejected_offsets;
+    int rejected_capacity;
+
+    int offsets_capacity; // Of both offset arrays
+} SchedulerContext;
 
-Schedule rejected[NUM_OF_MEMBER][MAX_BOOKINGS];
-int rejected_count[NUM_OF_MEMBER] = {0};
+// Decides one day's bookings (entries are booking indices in the algorithm's order)
+typedef void (*DayScheduler)(SchedulerContext* ctx, SlotAllocator* slots, RecordWriter* writer, const int* entries, int count);
 
-Booking refer_booking[MAX_BOOKINGS]; // Refer bookings with s.id
-Booking bookings[MAX_BOOKINGS];
-Schedule schedule[MAX_BOOKINGS];
+// Buffered line reader over a file descriptor. Lines are handed out as pointers into the buffer
+// (the '\n' replaced by '\0'), so commands are never copied before they are tokenized.
+typedef struct {
+    int fd;
+    char* buffer;
+    int capacity; // Grows when a single line does not fit
+    int start;    // First byte not yet handed out
+    int end;      // One past the last byte read
+    bool eof;
+} LineReader;
+
+// One line of a batch file window, filled in by the parse workers
+typedef struct {
+    int kind;        // BatchLineKind
+    int length;      // Without the '\n'
+    long offset;     // From the start of the batch file
+    Booking booking; // kind == BATCH_LINE_BOOKING
+} BatchLine;
 
-int facility_availability[MAX_FACILITIES] = {3, 3, 3, 3, 3, 3}; // 3 of each facility
-const char* facility_names[MAX_FACILITIES] = {"battery", "cable", "umbrella", "locker", "valetpark", "inflation"};
+typedef struct {
+    long long calls;
+    long long nanoseconds;
+} StatTotals;
 
-int summary[NUM_ALGORITHMS][4] = {0}; // [algorithm][metric]
-// Metrics: [0] = Total bookings, [1] = Assigned, [2] = Rejected, [3] = Invalid
+// printBookings output, formatted by hand into one big buffer instead of a printf per field
+typedef struct {
+    int fd;
+    char* buffer;
+    size_t used;
+} ReportWriter;
 
+// Global Variables
+// All booking storage is heap allocated and grows on demand (see reserve_bookings)
+BookingTable bookings;
+int booking_capacity = 0;
 int booking_count = 0;
-int schedule_count = 0;
+
+const char* record_status_names[] = {"Scheduled", "Rejected"}; // Indexed by RecordStatus
+
+SiteConfig site;
+MemberRegistry members;
+
+#define CONTEXT_POOL_SIZE NUM_ALGORITHMS
+SchedulerContext* context_pool[CONTEXT_POOL_SIZE];
+int context_pool_count = 0;
+
+SlotPolicy slot_policy = SLOT_FIRST_FIT;
+
+OccupancyIndex fcfs_occupancy; // queryAvailability answers for a booking FCFS would decide
+ScheduleCache schedule_caches[NUM_ALGORITHMS] = {[ALGORITHM_FCFS] = {.occupancy = &fcfs_occupancy}}; // Owned by printBookings
+
+WriteAheadLog wal = {.fd = -1};
+
+// Every process adds to its own stat_local and folds it into the shared stat_totals before it forks or exits,
+// so the counters of forked schedulers, reporters and workers all end up in the main process
+const char* stat_names[NUM_STATS] = {"parse", "sort", "slot allocation", "facility reserve", "pipe write", "child parse", "wal sync"};
+StatTotals stat_local[NUM_STATS];
+StatTotals* stat_totals = NULL;
 
 // Function Prototypes
-void processInput(FILE* input, bool isBatchFile);
-void add_booking(const char* command, int id);
-void fcfs_schedule_to_pipe(int pipe_fd);
-void shortest_job_first_to_pipe(int pipe_fd);
-void priority_schedule_to_pipe(int pipe_fd);
-void printBookings(const char* algorithm, int pipe_fd);
+void processInput(int input_fd, bool isBatchFile);
+bool run_daemon(const char* socket_path);
+bool process_command(char* line, int length, bool isBatchFile);
+bool process_batch_in_parallel(int batch_fd);
+int trim_line(char* line, int length);
+void add_booking(char* command);
+void reserve_bookings(int needed);
+void detach_snapshot();
+void free_booking_columns();
+bool save_snapshot(const char* path);
+bool load_snapshot(const char* path);
+bool wal_open(const char* path);
+void wal_append_booking(const Booking* b);
+void wal_checkpoint();
+void wal_sync();
+int wal_idle();
+void wal_wait_for_input(int input_fd);
+void wal_close();
+void invalidate_schedule_caches();
+void occupancy_update(OccupancyIndex* index, const ScheduleCache* cache, int from);
+void query_availability(char* args);
+void append_booking(const Booking* b);
+ParseResult parse_booking(char* command, Booking* b, bool intern_new_names);
+void fcfs_schedule_to_pipe(SchedulerContext* ctx, ScheduleChannel* channel, const ScheduleCache* cache);
+void update_fcfs_schedule();
+void shortest_job_first_to_pipe(SchedulerContext* ctx, ScheduleChannel* channel, const ScheduleCache* cache);
+void priority_schedule_to_pipe(SchedulerContext* ctx, ScheduleChannel* channel, const ScheduleCache* cache);
+void printBookings(SchedulerContext* ctx, const char* algorithm, ScheduleChannel* channel);
 void run_scheduling(const char* algorithm, void (*schedule_function)(int));
 bool validateAddBatchCommand(const char* command);
 bool validatePrintBooking(const char* algorithm);
 CommandType parseCommandType(const char* command);
 bool validateCommandFormat(const char* command, CommandType cmdType);
-void processBooking(const char* command);
-int convert_time_to_int(const char* time_str);
+void processBooking(char* command);
+void line_reader_init(LineReader* reader, int fd);
+char* line_reader_next(LineReader* reader, int* length);
+void line_reader_free(LineReader* reader);
+int convert_time_to_minutes(const char* time_str);
+int convert_date_to_days(const char* date);
 int convert_date_to_int(const char* date);
-void parse_and_classify_line(const char* line);
+bool parse_schedule_line(const char* line, ScheduleRecord* record);
+void classify_records(SchedulerContext* ctx, const ScheduleRecord* records, int count);
+void open_schedule_channel(ScheduleChannel* channel, int capacity);
+void close_schedule_channel(ScheduleChannel* channel);
+void record_writer_init(RecordWriter* writer, ScheduleChannel* channel);
+void record_writer_finish(RecordWriter* writer);
+void emit_schedule(RecordWriter* writer, const Schedule* s);
+void report_writer_init(ReportWriter* report, int fd);
+void report_writer_flush(ReportWriter* report);
+void report_writer_free(ReportWriter* report);
+void report_printf(ReportWriter* report, const char* format, ...);
+void report_booking_row(ReportWriter* report, const Schedule* s);
 int get_priority(const char* type);
-int get_index_from_member(char* member);
+void init_members();
+int member_id(const char* name);
+int intern_member(const char* name);
 void load_dummy_data();
 void initialize_pipe(int pipe_fd[2]);
 pid_t fork_process();
 void handle_child_process(int pipe_fd[2], const char* algorithm);
 void handle_parent_process(int pipe_fd[2], void (*schedule_function)(int));
-void reset_global_variables(bool reset_summary);
-void generate_performance_report();
-bool check_and_reserve_facilities(Booking* b);
+SchedulerContext* acquire_scheduler_context();
+void release_scheduler_context(SchedulerContext* ctx);
+void reset_scheduler_context(SchedulerContext* ctx);
+void generate_performance_report(int summary[NUM_ALGORITHMS][4]);
+void run_all_algorithms();
+bool check_and_reserve_facilities(SchedulerContext* ctx, int booking);
+void* grow_array(void* array, int* capacity, int needed, size_t elem_size);
+void calendar_sort_key(SortKey* key, int index, SortOrder order);
+void ready_queue_push(ReadyQueue* queue, int index);
+int ready_queue_pop(ReadyQueue* queue);
+void merge_sort_keys(SortKey* keys, int n);
+void slot_allocator_init(SlotAllocator* allocator, int bay_count);
+void slot_allocator_free(SlotAllocator* allocator);
+int slot_allocator_find(const SlotAllocator* allocator, int start_time, SlotPolicy policy);
+void slot_allocator_assign(SlotAllocator* allocator, int bay, int free_at);
+void slot_allocator_reset(SlotAllocator* allocator);
+void facility_timeline_start_day(FacilityTimeline* timeline, int day_start);
+void facility_timeline_free(FacilityTimeline* timeline);
+void build_calendar_index(CalendarIndex* calendar, const int* indices, int count, SortOrder order, int latest_end);
+void free_calendar_index(CalendarIndex* calendar);
+void schedule_by_day(SchedulerContext* ctx, ScheduleChannel* channel, SortOrder order, DayScheduler schedule_day, const ScheduleCache* cache);
+void schedule_cache_store(ScheduleCache* cache, const ScheduleRecord* records, int from, int count);
+void store_schedule(ScheduleCache* cache, const ScheduleChannel* channel);
+void load_default_site();
+bool load_site_config(const char* path);
+int add_site_facility(const char* name, int capacity);
+int facility_id(const char* name);
+int intern_facility(const char* name);
+void stats_init();
+void stats_flush();
+void print_stats(const char* json_path);
+
+// Statistics Functions
+// Monotonic clock in nanoseconds, comparable between the forked processes
+static inline long long stat_clock() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// calls operations of one kind took since started
+static inline void stat_record(StatCounter counter, long long calls, long long started) {
+    stat_local[counter].calls += calls;
+    stat_local[counter].nanoseconds += stat_clock() - started;
+}
+#define STAT_START(var) long long var = stat_clock()
+#define STAT_END(counter, var) stat_record(counter, 1, var)
+// Sampled variant for calls that take well under a microsecond, where reading the clock every time would show
+#define STAT_SAMPLE_START(counter, var) \
+    long long var = (stat_local[counter].calls++ % STAT_SAMPLE_EVERY == 0) ? stat_clock() : 0
+#define STAT_SAMPLE_END(counter, var) \
+    do { if (var != 0) stat_local[counter].nanoseconds += (stat_clock() - var) * STAT_SAMPLE_EVERY; } while (0)
+
+#ifdef BENCHMARK
+// Monotonic clock in milliseconds, comparable between the forked processes
+static double bench_now() {
+    return stat_clock() / 1000000.0;
+}
 
+// One machine readable line per measured phase on stderr, collected by benchmark_G40
+static void bench_report(const char* phase, const char* algorithm, double started) {
+    fprintf(stderr, "BENCH phase=%s algorithm=%s bookings=%d ms=%.3f\n", phase, algorithm, booking_count, bench_now() - started);
+}
+#define BENCH_START(var) double var = bench_now()
+#define BENCH_END(phase, algorithm, var) bench_report(phase, algorithm, var)
+#else
+#define BENCH_START(var)
+#define BENCH_END(phase, algorithm, var)
+#endif
+
+// Make sure array has room for at least `needed` elements, doubling the capacity so appends are amortized O(1)
+void* grow_array(void* array, int* capacity, int needed, size_t elem_size) {
+    if (needed <= *capacity) {
+        return array;
+    }
 
-void reset_global_variables(bool reset_summary) {
-    // Reset accepted and rejected schedules
-    for (int i = 0; i < NUM_OF_MEMBER; i++) {
-        accepted_count[i] = 0;
-        rejected_count[i] = 0;
+    int new_capacity = (*capacity > 0) ? *capacity : INITIAL_BOOKING_CAPACITY;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
     }
 
-    // Reset schecdule
-    schedule_count = 0;
+    void* grown = realloc(array, (size_t)new_capacity * elem_size);
+    if (grown == NULL) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = new_capacity;
+    return grown;
+}
 
-    // Reset facility availability
-    for (int i = 0; i < MAX_FACILITIES; i++) {
-        facility_availability[i] = 3; // Reset to initial availability (3 of each facility)
+// Take a context from the pool (or allocate one), ready for a new run
+SchedulerContext* acquire_scheduler_context() {
+    SchedulerContext* ctx;
+    if (context_pool_count > 0) {
+        ctx = context_pool[--context_pool_count];
+    } else {
+        ctx = calloc(1, sizeof(SchedulerContext));
+        if (ctx == NULL) {
+            perror("calloc");
+            exit(EXIT_FAILURE);
+        }
     }
+    reset_scheduler_context(ctx);
+    return ctx;
+}
 
-    // Reset summary metrics only if specified
-    if (reset_summary) {
-        memset(summary, 0, sizeof(summary));
+// Give a context back to the pool, its arrays are kept for the next run
+void release_scheduler_context(SchedulerContext* ctx) {
+    if (context_pool_count < CONTEXT_POOL_SIZE) {
+        context_pool[context_pool_count++] = ctx;
+        return;
     }
+
+    free(ctx->accepted);
+    free(ctx->accepted_offsets);
+    free(ctx->rejected);
+    free(ctx->rejected_offsets);
+    facility_timeline_free(&ctx->facilities);
+    free(ctx);
+}
+
+// Only counters and the facility reservations are reset, the arrays are reused as they are
+void reset_scheduler_context(SchedulerContext* ctx) {
+    ctx->facilities.carried_count = 0;
+    memset(ctx->summary, 0, sizeof(ctx->summary));
 }
 
-void generate_performance_report() {
+void generate_performance_report(int summary[NUM_ALGORITHMS][4]) {
     printf("\n\n*** Parking Booking Manager - Summary Report ***\n\n");
 
     const char* algorithms[] = {"FCFS", "PRIO", "SJF"};
@@ -137,11 +692,104 @@ void generate_performance_report() {
     }
 }
 
+// Shared totals for the whole run, mapped before the first fork
+void stats_init() {
+    stat_totals = mmap(NULL, sizeof(StatTotals) * NUM_STATS, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (stat_totals == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Fold this process's counters into the shared totals. Call before fork (so the child starts from zero)
+// and before a child exits; concurrent workers may flush at the same time.
+void stats_flush() {
+    for (int i = 0; i < NUM_STATS; i++) {
+        if (stat_local[i].calls == 0) continue;
+        __atomic_fetch_add(&stat_totals[i].calls, stat_local[i].calls, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stat_totals[i].nanoseconds, stat_local[i].nanoseconds, __ATOMIC_RELAXED);
+        stat_local[i].calls = 0;
+        stat_local[i].nanoseconds = 0;
+    }
+}
+
+// printStats: totals since the program started, also written as JSON to json_path when given
+void print_stats(const char* json_path) {
+    stats_flush();
+
+    printf("\n*** Runtime Statistics ***\n\n");
+    printf("%-18s%12s%14s%14s\n", "Phase", "Calls", "Total(ms)", "Average(us)");
+    printf("==========================================================\n");
+    for (int i = 0; i < NUM_STATS; i++) {
+        long long calls = stat_totals[i].calls;
+        double total_ms = stat_totals[i].nanoseconds / 1000000.0;
+        double average_us = (calls > 0) ? stat_totals[i].nanoseconds / 1000.0 / calls : 0.0;
+        printf("%-18s%12lld%14.3f%14.3f\n", stat_names[i], calls, total_ms, average_us);
+    }
+    printf("\nBookings: %d\n", booking_count);
+
+    if (json_path == NULL) return;
+
+    FILE* out = fopen(json_path, "w");
+    if (out == NULL) {
+        printf("Error: Cannot write stats file: %s\n", json_path);
+        return;
+    }
+    fprintf(out, "{\n  \"bookings\": %d,\n  \"phases\": [\n", booking_count);
+    for (int i = 0; i < NUM_STATS; i++) {
+        fprintf(out, "    {\"phase\": \"%s\", \"calls\": %lld, \"nanoseconds\": %lld}%s\n",
+                stat_names[i], stat_totals[i].calls, stat_totals[i].nanoseconds, (i + 1 < NUM_STATS) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+    printf("Statistics written to %s\n", json_path);
+}
+
 // Utility Functions
-int convert_time_to_int(const char* time_str) {
-    int h, m;
-    sscanf(time_str, "%d:%d", &h, &m);
-    return h;
+// Read an unsigned decimal number at *p and move past it, -1 if there is no digit
+static int read_number(const char** p) {
+    const char* s = *p;
+    int value = 0;
+    if (*s < '0' || *s > '9') return -1;
+    while (*s >= '0' && *s <= '9' && value < INF / 10) {
+        value = value * 10 + (*s++ - '0');
+    }
+    *p = s;
+    return value;
+}
+
+// Minutes since midnight for "hh:mm", -1 if malformed
+int convert_time_to_minutes(const char* time_str) {
+    int h = read_number(&time_str);
+    if (h < 0 || *time_str++ != ':') return -1;
+    int m = read_number(&time_str);
+    if (h > 23 || m < 0 || m > 59 || *time_str != '\0') return -1;
+    return h * 60 + m;
+}
+
+// Booking length in hours: positive, finite and at most MAX_BOOKING_HOURS (nan fails both comparisons)
+static bool valid_duration(float hours) {
+    return hours > 0.0f && hours <= MAX_BOOKING_HOURS;
+}
+
+// Days since 1970-01-01 for "YYYY-MM-DD" (proleptic Gregorian, years 1970 to MAX_YEAR), -1 if malformed or no such day
+int convert_date_to_days(const char* date) {
+    int y = read_number(&date);
+    if (y < 0 || *date++ != '-') return -1;
+    int m = read_number(&date);
+    if (m < 0 || *date++ != '-') return -1;
+    int d = read_number(&date);
+    if (y < 1970 || y > MAX_YEAR || m < 1 || m > 12 || d < 1 || *date != '\0') return -1;
+    static const int month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    if (d > month_days[m - 1] + (m == 2 && leap)) return -1;
+
+    y -= (m <= 2);
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
 }
 
 int convert_date_to_int(const char* date) {
@@ -158,225 +806,2107 @@ int get_priority(const char* type) {
     return 5; 
 }
 
-int get_index_from_member(char* member) {
-    if (strncmp(member, "member_", 7) == 0) {
-        char ch = member[7];
-        if (ch >= 'A' && ch <= 'E') return ch - 'A';
+// Sorting Functions
+static bool sort_key_less(const SortKey* a, const SortKey* b) {
+    if (a->primary != b->primary) return a->primary < b->primary;
+    if (a->secondary != b->secondary) return a->secondary < b->secondary;
+    return a->index < b->index;
+}
+
+// Bottom-up merge sort, O(n log n) and stable: on equal keys the left run always wins
+void merge_sort_keys(SortKey* keys, int n) {
+    SortKey* tmp = malloc((size_t)(n > 0 ? n : 1) * sizeof(SortKey));
+    if (tmp == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
     }
-    return -1;
+
+    SortKey* src = keys;
+    SortKey* dst = tmp;
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = (lo + width < n) ? lo + width : n;
+            int hi = (lo + 2 * width < n) ? lo + 2 * width : n;
+            int i = lo, j = mid, k = lo;
+
+            while (i < mid && j < hi) {
+                dst[k++] = sort_key_less(&src[j], &src[i]) ? src[j++] : src[i++];
+            }
+            while (i < mid) dst[k++] = src[i++];
+            while (j < hi) dst[k++] = src[j++];
+        }
+        SortKey* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != keys) {
+        memcpy(keys, src, (size_t)n * sizeof(SortKey));
+    }
+    free(tmp);
 }
 
-// Validation Functions
-bool validateAddBatchCommand(const char* command) {
-    return (strncmp(command, "addBatch -", 10) == 0);
+// Key that puts a booking in calendar order: by day, then the algorithm's order within the day, then arrival
+void calendar_sort_key(SortKey* key, int index, SortOrder order) {
+    key->index = index;
+    if (order == SORT_BY_START_TIME) {
+        key->primary = bookings.start_minute[index]; // Already orders by day
+        key->secondary = 0;
+    } else {
+        key->primary = bookings.start_minute[index] / MINUTES_PER_DAY;
+        key->secondary = (order == SORT_BY_PRIORITY) ? bookings.priority[index] : 0;
+    }
 }
 
-bool validatePrintBooking(const char* algorithm) {
-    return (strcmp(algorithm, "fcfs") == 0 ||
-            strcmp(algorithm, "sjf") == 0 ||
-            strcmp(algorithm, "prio") == 0 ||
-            strcmp(algorithm, "all") == 0);
+static bool ready_before(int a, int b) {
+    int duration_a = bookings.end_minute[a] - bookings.start_minute[a];
+    int duration_b = bookings.end_minute[b] - bookings.start_minute[b];
+    if (duration_a != duration_b) return duration_a < duration_b;
+    return a < b;
 }
 
-CommandType parseCommandType(const char* command) {
-    if (strncmp(command, "addParking", 10) == 0) return CMD_ADD_PARKING;
-    if (strncmp(command, "addReservation", 14) == 0) return CMD_ADD_RESERVATION;
-    if (strncmp(command, "addEvent", 8) == 0) return CMD_ADD_EVENT;
-    if (strncmp(command, "bookEssentials", 14) == 0) return CMD_BOOK_ESSENTIALS;
-    return CMD_INVALID;
+// items must have room for one more booking
+void ready_queue_push(ReadyQueue* queue, int index) {
+    int i = queue->count++;
+    while (i > 0 && ready_before(index, queue->items[(i - 1) / 2])) {
+        queue->items[i] = queue->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    queue->items[i] = index;
 }
 
-bool validateCommandFormat(const char* command, CommandType cmdType) {
-    switch (cmdType) {
-        case CMD_ADD_PARKING:
-        case CMD_ADD_RESERVATION:
-        case CMD_ADD_EVENT:
-        case CMD_BOOK_ESSENTIALS:
-            return (strchr(command, '-') != NULL); 
-        default:
-            return false;
+// Remove and return the shortest ready booking; the queue must not be empty
+int ready_queue_pop(ReadyQueue* queue) {
+    int top = queue->items[0];
+    int last = queue->items[--queue->count];
+    int i = 0;
+    while (2 * i + 1 < queue->count) {
+        int child = 2 * i + 1;
+        if (child + 1 < queue->count && ready_before(queue->items[child + 1], queue->items[child])) child++;
+        if (!ready_before(queue->items[child], last)) break;
+        queue->items[i] = queue->items[child];
+        i = child;
+    }
+    queue->items[i] = last;
+    return top;
+}
+
+// Slot Allocator Functions
+void slot_allocator_init(SlotAllocator* allocator, int bay_count) {
+    allocator->bay_count = bay_count;
+    allocator->leaves = 1;
+    while (allocator->leaves < bay_count) {
+        allocator->leaves *= 2;
+    }
+
+    allocator->min_free = malloc(2 * (size_t)allocator->leaves * sizeof(int));
+    allocator->left = malloc((size_t)bay_count * sizeof(int));
+    allocator->right = malloc((size_t)bay_count * sizeof(int));
+    if (allocator->min_free == NULL || allocator->left == NULL || allocator->right == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    slot_allocator_reset(allocator);
+}
+
+// Treap priority of a bay: a fixed hash, so the shape does not depend on the order bays were assigned in
+static unsigned int bay_priority(int bay) {
+    unsigned int x = (unsigned int)bay * 0x9E3779B1u + 0x7F4A7C15u;
+    x ^= x >> 15;
+    x *= 0x85EBCA77u;
+    x ^= x >> 13;
+    return x;
+}
+
+// Treap order: earlier free at time first, and among equal ones the higher bay first
+static bool bay_before(const SlotAllocator* allocator, int a, int b) {
+    int free_a = allocator->min_free[allocator->leaves + a], free_b = allocator->min_free[allocator->leaves + b];
+    return free_a < free_b || (free_a == free_b && a > b);
+}
+
+// Every bay free again
+void slot_allocator_reset(SlotAllocator* allocator) {
+    int bay_count = allocator->bay_count;
+
+    // Real bays are free from time 0, padding leaves are never free
+    for (int i = 0; i < allocator->leaves; i++) {
+        allocator->min_free[allocator->leaves + i] = (i < bay_count) ? 0 : INF;
+    }
+    for (int i = allocator->leaves - 1; i >= 1; i--) {
+        int l = allocator->min_free[2 * i], r = allocator->min_free[2 * i + 1];
+        allocator->min_free[i] = (l < r) ? l : r;
+    }
+
+    // All bays tie at 0, so the treap order is the highest bay down to bay 0. Build it in O(S) along its right
+    // spine: each bay becomes the right child of the last spine bay with a higher priority and takes the bays
+    // it pops off the spine as its left subtree. right[] of the spine bays doubles as the stack.
+    int spine = -1; // Lowest bay on the right spine, right[] links each spine bay to the one above it
+    for (int bay = bay_count - 1; bay >= 0; bay--) {
+        int popped = -1;
+        while (spine >= 0 && bay_priority(spine) < bay_priority(bay)) {
+            int above = allocator->right[spine];
+            allocator->right[spine] = popped;
+            popped = spine;
+            spine = above;
+        }
+        allocator->left[bay] = popped;
+        allocator->right[bay] = spine;
+        spine = bay;
+    }
+
+    // Turn the upward links of the spine back into right children
+    int below = -1;
+    while (spine >= 0) {
+        int above = allocator->right[spine];
+        allocator->right[spine] = below;
+        below = spine;
+        spine = above;
+    }
+    allocator->root = below;
+}
+
+void slot_allocator_free(SlotAllocator* allocator) {
+    free(allocator->min_free);
+    free(allocator->left);
+    free(allocator->right);
+    allocator->min_free = NULL;
+    allocator->left = NULL;
+    allocator->right = NULL;
+}
+
+// Join two treaps, every bay of a ordered before every bay of b
+static int bay_treap_merge(SlotAllocator* allocator, int a, int b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    if (bay_priority(a) > bay_priority(b)) {
+        allocator->right[a] = bay_treap_merge(allocator, allocator->right[a], b);
+        return a;
+    }
+    allocator->left[b] = bay_treap_merge(allocator, a, allocator->left[b]);
+    return b;
+}
+
+// Split a treap into the bays ordered before bay and the ones after it (bay itself is not in it)
+static void bay_treap_split(SlotAllocator* allocator, int node, int bay, int* before, int* after) {
+    if (node < 0) {
+        *before = *after = -1;
+    } else if (bay_before(allocator, node, bay)) {
+        bay_treap_split(allocator, allocator->right[node], bay, &allocator->right[node], after);
+        *before = node;
+    } else {
+        bay_treap_split(allocator, allocator->left[node], bay, before, &allocator->left[node]);
+        *after = node;
+    }
+}
+
+// Leftmost bay free at start_time, O(log S): descend into the left child whenever its min qualifies
+static int slot_find_first_fit(const SlotAllocator* allocator, int start_time) {
+    if (allocator->min_free[1] > start_time) return -1;
+
+    int node = 1;
+    while (node < allocator->leaves) {
+        node = (allocator->min_free[2 * node] <= start_time) ? 2 * node : 2 * node + 1;
+    }
+    return node - allocator->leaves;
+}
+
+// Bay with the latest free-at time that is still <= start_time, ties go to the lower bay: the last bay in treap
+// order that is free, found in one descent, O(log S) expected
+static int slot_find_best_fit(const SlotAllocator* allocator, int start_time) {
+    int best = -1;
+    for (int node = allocator->root; node >= 0;) {
+        if (allocator->min_free[allocator->leaves + node] <= start_time) {
+            best = node;
+            node = allocator->right[node];
+        } else {
+            node = allocator->left[node];
+        }
+    }
+    return best;
+}
+
+// Returns the 0-based bay to use for a booking starting at start_time, or -1 if every bay is busy
+int slot_allocator_find(const SlotAllocator* allocator, int start_time, SlotPolicy policy) {
+    STAT_SAMPLE_START(STAT_SLOT_ALLOCATION, started);
+    int bay;
+    if (policy == SLOT_BEST_FIT) {
+        bay = slot_find_best_fit(allocator, start_time);
+    } else {
+        bay = slot_find_first_fit(allocator, start_time);
+    }
+    STAT_SAMPLE_END(STAT_SLOT_ALLOCATION, started);
+    return bay;
+}
+
+// Mark bay busy until free_at: refresh the segment tree path to the root, O(log S), and move the bay to its new
+// place in the treap, O(log S) expected
+void slot_allocator_assign(SlotAllocator* allocator, int bay, int free_at) {
+    STAT_SAMPLE_START(STAT_SLOT_ALLOCATION, started);
+    int* link = &allocator->root;
+    while (*link != bay) {
+        link = bay_before(allocator, bay, *link) ? &allocator->left[*link] : &allocator->right[*link];
+    }
+    *link = bay_treap_merge(allocator, allocator->left[bay], allocator->right[bay]);
+
+    int node = allocator->leaves + bay;
+    allocator->min_free[node] = free_at;
+    for (node /= 2; node >= 1; node /= 2) {
+        int l = allocator->min_free[2 * node], r = allocator->min_free[2 * node + 1];
+        allocator->min_free[node] = (l < r) ? l : r;
+    }
+
+    link = &allocator->root;
+    while (*link >= 0 && bay_priority(*link) > bay_priority(bay)) {
+        link = bay_before(allocator, bay, *link) ? &allocator->left[*link] : &allocator->right[*link];
+    }
+    bay_treap_split(allocator, *link, bay, &allocator->left[bay], &allocator->right[bay]);
+    *link = bay;
+    STAT_SAMPLE_END(STAT_SLOT_ALLOCATION, started);
+}
+
+// Facility Timeline Functions
+static void timeline_update(int* used, int* added, int node, int lo, int hi, int from, int to, int units) {
+    if (to <= lo || hi <= from) return;
+    if (from <= lo && hi <= to) {
+        used[node] += units;
+        added[node] += units;
+        return;
+    }
+    int mid = (lo + hi) / 2;
+    timeline_update(used, added, 2 * node, lo, mid, from, to, units);
+    timeline_update(used, added, 2 * node + 1, mid, hi, from, to, units);
+    int l = used[2 * node], r = used[2 * node + 1];
+    used[node] = ((l > r) ? l : r) + added[node];
+}
+
+static int timeline_query(const int* used, const int* added, int node, int lo, int hi, int from, int to) {
+    if (to <= lo || hi <= from) return 0;
+    if (from <= lo && hi <= to) return used[node];
+    int mid = (lo + hi) / 2;
+    int l = timeline_query(used, added, 2 * node, lo, mid, from, to);
+    int r = timeline_query(used, added, 2 * node + 1, mid, hi, from, to);
+    return ((l > r) ? l : r) + added[node];
+}
+
+// Booking's minutes as leaves of the current day's trees, cut to the minute after midnight
+static void timeline_range(const FacilityTimeline* timeline, int booking, int* from, int* to) {
+    *from = bookings.start_minute[booking] - timeline->origin;
+    *to = bookings.end_minute[booking] - timeline->origin;
+    if (*from < 0) *from = 0;
+    if (*to > MINUTES_PER_DAY + 1) *to = MINUTES_PER_DAY + 1;
+}
+
+// A facility's tree, zeroed the first time it is used on the current day
+static int timeline_tree(FacilityTimeline* timeline, int facility, int** added) {
+    size_t offset = (size_t)facility * 2 * TIMELINE_LEAVES;
+    if (!(timeline->cleared & (1u << facility))) {
+        memset(timeline->used + offset, 0, 2 * TIMELINE_LEAVES * sizeof(int));
+        memset(timeline->added + offset, 0, 2 * TIMELINE_LEAVES * sizeof(int));
+        timeline->cleared |= 1u << facility;
     }
+    *added = timeline->added + offset;
+    return (int)offset;
 }
 
-void processBooking(const char* command) {
-    add_booking(command, booking_count); 
+// Most units of facility in use at any minute of [from, to)
+static int facility_timeline_max(FacilityTimeline* timeline, int facility, int from, int to) {
+    int* added;
+    int offset = timeline_tree(timeline, facility, &added);
+    return timeline_query(timeline->used + offset, added, 1, 0, TIMELINE_LEAVES, from, to);
 }
 
-bool check_and_reserve_facilities(Booking* b) {
-    int temp_availability[MAX_FACILITIES];
-    memcpy(temp_availability, facility_availability, sizeof(facility_availability));
+static void facility_timeline_add(FacilityTimeline* timeline, int facility, int from, int to, int units) {
+    int* added;
+    int offset = timeline_tree(timeline, facility, &added);
+    timeline_update(timeline->used + offset, added, 1, 0, TIMELINE_LEAVES, from, to, units);
+}
 
-    for (int i = 0; i < b->facility_count; i++) {
-        int facility_index = -1;
-        for (int j = 0; j < MAX_FACILITIES; j++) {
-            if (strcmp(b->facilities[i], facility_names[j]) == 0) {
-                facility_index = j;
-                break;
+// Units of each facility a booking (or a query) holds: every requested facility and its pair (battery + cable, locker +
+// umbrella, etc according to the site rules). Returns the number of different facilities.
+static int facility_demand(const FacilityList* facilities, int ids[2 * MAX_FACILITIES], int units[2 * MAX_FACILITIES]) {
+    int count = 0;
+    for (int i = 0; i < facilities->count; i++) {
+        int wanted[2] = {facilities->ids[i], site.facility_pair[facilities->ids[i]]};
+        for (int w = 0; w < 2 && wanted[w] >= 0; w++) {
+            int k = 0;
+            while (k < count && ids[k] != wanted[w]) k++;
+            if (k == count) {
+                ids[count] = wanted[w];
+                units[count++] = 0;
             }
+            units[k]++;
+        }
+    }
+    return count;
+}
+
+// Move on to the day starting at day_start: every tree is empty again, except for the bookings carried over
+// from earlier days that still run at midnight
+void facility_timeline_start_day(FacilityTimeline* timeline, int day_start) {
+    if (timeline->facility_count < site.facility_count) {
+        size_t size = (size_t)site.facility_count * 2 * TIMELINE_LEAVES * sizeof(int);
+        free(timeline->used);
+        free(timeline->added);
+        timeline->used = malloc(size);
+        timeline->added = malloc(size);
+        if (timeline->used == NULL || timeline->added == NULL) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        timeline->facility_count = site.facility_count;
+    }
+    timeline->origin = day_start;
+    timeline->cleared = 0;
+
+    int kept = 0;
+    for (int i = 0; i < timeline->carried_count; i++) {
+        int b = timeline->carried[i];
+        if (bookings.end_minute[b] <= day_start) continue;
+        timeline->carried[kept++] = b;
+
+        int ids[2 * MAX_FACILITIES], units[2 * MAX_FACILITIES], from, to;
+        int count = facility_demand(&bookings.facilities[b], ids, units);
+        timeline_range(timeline, b, &from, &to);
+        for (int k = 0; k < count; k++) {
+            facility_timeline_add(timeline, ids[k], from, to, units[k]);
+        }
+    }
+    timeline->carried_count = kept;
+}
+
+void facility_timeline_free(FacilityTimeline* timeline) {
+    free(timeline->used);
+    free(timeline->added);
+    free(timeline->carried);
+    memset(timeline, 0, sizeof(*timeline));
+}
+
+// Site Configuration Functions
+static unsigned int hash_name(const char* name) {
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (; *name; name++) {
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    }
+    return hash;
+}
+
+// Look up a facility id by name, -1 if the site has no such facility
+int facility_id(const char* name) {
+    unsigned int slot = hash_name(name) & (FACILITY_HASH_SIZE - 1);
+    while (site.facility_lookup[slot] >= 0) {
+        int id = site.facility_lookup[slot];
+        if (strcmp(site.facility_names[id], name) == 0) return id;
+        slot = (slot + 1) & (FACILITY_HASH_SIZE - 1);
+    }
+    return -1;
+}
+
+// Register a facility and return its id, or -1 if it is a duplicate or the table is full
+int add_site_facility(const char* name, int capacity) {
+    if (site.facility_count >= MAX_SITE_FACILITIES || strlen(name) >= MAX_FACILITY_NAME_LENGTH || facility_id(name) >= 0) {
+        return -1;
+    }
+
+    int id = site.facility_count++;
+    strcpy(site.facility_names[id], name);
+    site.facility_capacity[id] = capacity;
+    site.facility_pair[id] = -1;
+
+    unsigned int slot = hash_name(name) & (FACILITY_HASH_SIZE - 1);
+    while (site.facility_lookup[slot] >= 0) {
+        slot = (slot + 1) & (FACILITY_HASH_SIZE - 1);
+    }
+    site.facility_lookup[slot] = (signed char)id;
+    return id;
+}
+
+// Facility id for a requested name. Names the site does not stock are interned with zero units,
+// so the booking keeps its name for the report and can never be granted.
+int intern_facility(const char* name) {
+    char truncated[MAX_FACILITY_NAME_LENGTH];
+    strncpy(truncated, name, MAX_FACILITY_NAME_LENGTH - 1);
+    truncated[MAX_FACILITY_NAME_LENGTH - 1] = '\0';
+
+    int id = facility_id(truncated);
+    return (id >= 0) ? id : add_site_facility(truncated, 0);
+}
+
+// Member Registry Functions
+// Look up a member id by client name, -1 if the member has not booked yet
+int member_id(const char* name) {
+    unsigned int mask = (unsigned int)members.lookup_size - 1;
+    unsigned int slot = hash_name(name) & mask;
+    while (members.lookup[slot] >= 0) {
+        int id = members.lookup[slot];
+        if (strcmp(members.names[id], name) == 0) return id;
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+static void insert_member_lookup(int id) {
+    unsigned int mask = (unsigned int)members.lookup_size - 1;
+    unsigned int slot = hash_name(members.names[id]) & mask;
+    while (members.lookup[slot] >= 0) {
+        slot = (slot + 1) & mask;
+    }
+    members.lookup[slot] = id;
+}
+
+// Member id for a client name, registering the member on first sight
+int intern_member(const char* name) {
+    int id = member_id(name);
+    if (id >= 0) return id;
+
+    id = members.count;
+    members.names = grow_array(members.names, &members.capacity, id + 1, sizeof(members.names[0]));
+    memset(members.names[id], 0, sizeof(members.names[id]));
+    strcpy(members.names[id], name);
+    members.count++;
+
+    // Keep the table at most half full, rehashing into one twice as big
+    if (members.count * 2 > members.lookup_size) {
+        free(members.lookup);
+        members.lookup_size *= 2;
+        members.lookup = malloc((size_t)members.lookup_size * sizeof(int));
+        if (members.lookup == NULL) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        memset(members.lookup, -1, (size_t)members.lookup_size * sizeof(int));
+        for (int i = 0; i < members.count; i++) {
+            insert_member_lookup(i);
         }
+    } else {
+        insert_member_lookup(id);
+    }
+    return id;
+}
+
+// The default members come first, so they keep their place at the top of every report.
+// Also starts the registry over when a snapshot replaces the bookings.
+void init_members() {
+    free(members.lookup);
+    members.count = 0;
+    members.generation++;
+    members.lookup_size = INITIAL_MEMBER_HASH_SIZE;
+    members.lookup = malloc((size_t)members.lookup_size * sizeof(int));
+    if (members.lookup == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(members.lookup, -1, (size_t)members.lookup_size * sizeof(int));
+
+    char name[MAX_NAME_LEN];
+    for (int i = 0; i < NUM_DEFAULT_MEMBERS; i++) {
+        snprintf(name, sizeof(name), "member_%c", 'A' + i);
+        intern_member(name);
+    }
+}
+
+// Built-in site used when no configuration file is given: 10 bays, 3 of each facility
+void load_default_site() {
+    const char* names[] = {"battery", "cable", "umbrella", "locker", "valetpark", "inflation"};
+
+    memset(&site, 0, sizeof(site));
+    memset(site.facility_lookup, -1, sizeof(site.facility_lookup));
+    site.bay_count = DEFAULT_PARKING_SLOTS;
+    for (int i = 0; i < 6; i++) {
+        add_site_facility(names[i], DEFAULT_FACILITY_UNITS);
+    }
+    for (int i = 0; i < 6; i += 2) {
+        site.facility_pair[i] = i + 1;
+        site.facility_pair[i + 1] = i;
+    }
+}
+
+/*
+Site file format, one directive per line ('#' starts a comment):
+    bays 10
+    facility battery 3
+    pair battery cable
+    policy first-fit | best-fit
+*/
+bool load_site_config(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("Error: Cannot open site configuration: %s\n", path);
+        return false;
+    }
+
+    memset(&site, 0, sizeof(site));
+    memset(site.facility_lookup, -1, sizeof(site.facility_lookup));
+
+    char line[MAX_LINE];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        char directive[MAX_NAME_LEN], first[MAX_NAME_LEN], second[MAX_NAME_LEN];
+        line_number++;
+
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        int fields = sscanf(line, "%49s %49s %49s", directive, first, second);
+        if (fields <= 0) continue;
+
+        if (strcmp(directive, "bays") == 0 && fields == 2) {
+            site.bay_count = atoi(first);
+            ok = site.bay_count > 0;
+        } else if (strcmp(directive, "facility") == 0 && fields == 3) {
+            ok = atoi(second) >= 0 && add_site_facility(first, atoi(second)) >= 0;
+        } else if (strcmp(directive, "pair") == 0 && fields == 3) {
+            // Pairs stay symmetric: a facility already paired with another one cannot be paired again
+            int a = facility_id(first), b = facility_id(second);
+            ok = a >= 0 && b >= 0 && a != b && (site.facility_pair[a] < 0 || site.facility_pair[a] == b) &&
+                 (site.facility_pair[b] < 0 || site.facility_pair[b] == a);
+            if (ok) {
+                site.facility_pair[a] = b;
+                site.facility_pair[b] = a;
+            }
+        } else if (strcmp(directive, "policy") == 0 && fields == 2) {
+            if (strcmp(first, "first-fit") == 0) slot_policy = SLOT_FIRST_FIT;
+            else if (strcmp(first, "best-fit") == 0) slot_policy = SLOT_BEST_FIT;
+            else ok = false;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            printf("Error: Invalid site configuration at %s:%d\n", path, line_number);
+        }
+    }
+    fclose(file);
+
+    if (ok && site.bay_count <= 0) {
+        printf("Error: Site configuration %s does not set the number of bays.\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+// Validation Functions
+bool validateAddBatchCommand(const char* command) {
+    return (strncmp(command, "addBatch -", 10) == 0);
+}
+
+bool validatePrintBooking(const char* algorithm) {
+    return (strcmp(algorithm, "fcfs") == 0 ||
+            strcmp(algorithm, "sjf") == 0 ||
+            strcmp(algorithm, "prio") == 0 ||
+            strcmp(algorithm, "all") == 0);
+}
+
+CommandType parseCommandType(const char* command) {
+    if (strncmp(command, "addParking", 10) == 0) return CMD_ADD_PARKING;
+    if (strncmp(command, "addReservation", 14) == 0) return CMD_ADD_RESERVATION;
+    if (strncmp(command, "addEvent", 8) == 0) return CMD_ADD_EVENT;
+    if (strncmp(command, "bookEssentials", 14) == 0) return CMD_BOOK_ESSENTIALS;
+    return CMD_INVALID;
+}
+
+bool validateCommandFormat(const char* command, CommandType cmdType) {
+    switch (cmdType) {
+        case CMD_ADD_PARKING:
+        case CMD_ADD_RESERVATION:
+        case CMD_ADD_EVENT:
+        case CMD_BOOK_ESSENTIALS:
+            return (strchr(command, '-') != NULL); 
+        default:
+            return false;
+    }
+}
+
+void processBooking(char* command) {
+    add_booking(command); 
+}
+
+// Reserve the booking's facilities for its own time only, if enough units are free at every minute of it, O(log T)
+bool check_and_reserve_facilities(SchedulerContext* ctx, int booking) {
+    STAT_SAMPLE_START(STAT_FACILITY_RESERVE, started);
+    FacilityTimeline* timeline = &ctx->facilities;
+    int ids[2 * MAX_FACILITIES], units[2 * MAX_FACILITIES], from, to;
+    int count = facility_demand(&bookings.facilities[booking], ids, units);
+    timeline_range(timeline, booking, &from, &to);
+
+    for (int k = 0; k < count; k++) {
+        if (site.facility_capacity[ids[k]] - facility_timeline_max(timeline, ids[k], from, to) < units[k]) {
+            STAT_SAMPLE_END(STAT_FACILITY_RESERVE, started);
+            return false;
+        }
+    }
+
+    // Reserve facilities
+    for (int k = 0; k < count; k++) {
+        facility_timeline_add(timeline, ids[k], from, to, units[k]);
+    }
+    if (bookings.end_minute[booking] > timeline->origin + MINUTES_PER_DAY) {
+        timeline->carried = grow_array(timeline->carried, &timeline->carried_capacity, timeline->carried_count + 1, sizeof(int));
+        timeline->carried[timeline->carried_count++] = booking;
+    }
+    STAT_SAMPLE_END(STAT_FACILITY_RESERVE, started);
+    return true;
+}
+
+// Booking Functions
+// Cut the next space separated token off *cursor in place and return its length, 0 at the end of the line
+static int next_token(char** cursor, char** token) {
+    char* p = *cursor;
+    while (*p == ' ' || *p == '\t') p++;
+    *token = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+    int length = (int)(p - *token);
+    if (*p != '\0') *p++ = '\0';
+    *cursor = p;
+    return length;
+}
+
+// Parse "type -client date time duration facilities..." in one pass. The command is tokenized in place.
+// With intern_new_names false the site and the member registry are only read: a facility the site does not know
+// yet fails, a client the registry does not know yet is left with member -1 for the caller to intern.
+ParseResult parse_booking(char* command, Booking* b, bool intern_new_names) {
+    char* cursor = command;
+    char *type, *client, *date, *time, *duration, *end;
+
+    // Parse the command
+    int type_len = next_token(&cursor, &type);
+    int client_len = next_token(&cursor, &client);
+    int date_len = next_token(&cursor, &date);
+    int time_len = next_token(&cursor, &time);
+    int duration_len = next_token(&cursor, &duration);
+    if (type_len == 0 || type_len >= MAX_NAME_LEN || client_len < 2 || client[0] != '-' || client_len > MAX_NAME_LEN ||
+        date_len == 0 || date_len >= MAX_DATE_LEN || time_len == 0 || time_len >= MAX_NAME_LEN || duration_len == 0) {
+        return PARSE_BAD_FORMAT;
+    }
+    b->duration = strtof(duration, &end);
+    if (end != duration + duration_len) {
+        return PARSE_BAD_FORMAT;
+    }
+    memset(&b->text, 0, sizeof(b->text)); // No stray stack bytes in saved snapshots
+    memcpy(b->text.type, type, (size_t)type_len + 1);
+    memcpy(b->text.client, client + 1, (size_t)client_len);
+    memcpy(b->text.date, date, (size_t)date_len + 1);
+    memcpy(b->text.time, time, (size_t)time_len + 1);
+
+    // Pack date and time into one timestamp so the schedulers never parse strings
+    int day = convert_date_to_days(b->text.date);
+    int minute = convert_time_to_minutes(b->text.time);
+    if (day < 0 || minute < 0 || !valid_duration(b->duration)) {
+        return PARSE_BAD_TIME;
+    }
+    b->start_minute = day * MINUTES_PER_DAY + minute;
+    b->end_minute = b->start_minute + (int)(b->duration * 60.0f + 0.5f);
+    b->type = (unsigned char)parseCommandType(b->text.type);
+    b->priority = (unsigned char)get_priority(b->text.type);
+
+    // Parse facilities
+    b->facilities.count = 0;
+    b->facility_mask = 0;
+    char* facility;
+    while (b->facilities.count < MAX_FACILITIES && next_token(&cursor, &facility) > 0) {
+        int id = intern_new_names ? intern_facility(facility) : facility_id(facility);
+        if (id < 0) {
+            return intern_new_names ? PARSE_TOO_MANY_FACILITIES : PARSE_NEW_FACILITY;
+        }
+        b->facilities.ids[b->facilities.count++] = (unsigned char)id;
+        b->facility_mask |= 1u << id;
+    }
+
+    // Last, so a booking that fails does not register its member
+    b->member = intern_new_names ? intern_member(b->text.client) : member_id(b->text.client);
+    return PARSE_OK;
+}
+
+// Make room for at least needed bookings in every column of the booking table
+void reserve_bookings(int needed) {
+    if (needed <= booking_capacity) return;
+    if (bookings.mapping != NULL) {
+        detach_snapshot();
+    }
+
+    int capacity = booking_capacity; // Every column grows from the same capacity to the same capacity
+#define GROW_COLUMN(name, type) \
+    capacity = booking_capacity; \
+    bookings.name = grow_array(bookings.name, &capacity, needed, sizeof(type));
+    BOOKING_COLUMNS(GROW_COLUMN)
+#undef GROW_COLUMN
+    booking_capacity = capacity;
+}
+
+// File a parsed booking under the next id
+void append_booking(const Booking* b) {
+    reserve_bookings(booking_count + 1);
+    int i = booking_count++;
+    bookings.start_minute[i] = b->start_minute;
+    bookings.end_minute[i] = b->end_minute;
+    bookings.duration[i] = b->duration;
+    bookings.member[i] = b->member;
+    bookings.type[i] = b->type;
+    bookings.priority[i] = b->priority;
+    bookings.facility_mask[i] = b->facility_mask;
+    bookings.facilities[i] = b->facilities;
+    bookings.text[i] = b->text;
+}
+
+void add_booking(char* command) {
+    Booking b;
+    STAT_SAMPLE_START(STAT_PARSE, started);
+    ParseResult result = parse_booking(command, &b, true);
+    STAT_SAMPLE_END(STAT_PARSE, started);
+    switch (result) {
+        case PARSE_OK:
+            if (wal.fd != -1) wal_append_booking(&b);
+            append_booking(&b);
+            break;
+        case PARSE_BAD_TIME:
+            printf("Error: Invalid booking date, time or duration.\n");
+            break;
+        case PARSE_TOO_MANY_FACILITIES:
+            printf("Error: Too many different facility names.\n");
+            break;
+        default:
+            printf("Error: Invalid booking format.\n");
+            break;
+    }
+}
+
+// Snapshot Functions
+// The columns point into a loaded snapshot: copy them to the heap before the table can grow
+void detach_snapshot() {
+    int count = booking_count;
+#define COPY_COLUMN(name, type) \
+    { \
+        type* column = malloc((size_t)(count > 0 ? count : 1) * sizeof(type)); \
+        if (column == NULL) { \
+            perror("malloc"); \
+            exit(EXIT_FAILURE); \
+        } \
+        memcpy(column, bookings.name, (size_t)count * sizeof(type)); \
+        bookings.name = column; \
+    }
+    BOOKING_COLUMNS(COPY_COLUMN)
+#undef COPY_COLUMN
+    munmap(bookings.mapping, bookings.mapped_size);
+    bookings.mapping = NULL;
+    booking_capacity = count;
+}
+
+void free_booking_columns() {
+    if (bookings.mapping != NULL) {
+        munmap(bookings.mapping, bookings.mapped_size);
+        bookings.mapping = NULL;
+    } else {
+#define FREE_COLUMN(name, type) free(bookings.name);
+        BOOKING_COLUMNS(FREE_COLUMN)
+#undef FREE_COLUMN
+    }
+#define CLEAR_COLUMN(name, type) bookings.name = NULL;
+    BOOKING_COLUMNS(CLEAR_COLUMN)
+#undef CLEAR_COLUMN
+    booking_count = 0;
+    booking_capacity = 0;
+}
+
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGN - 1) & ~(uint64_t)(SNAPSHOT_ALIGN - 1);
+}
+
+// Checksum of one section, chained through seed. Four independent multiply-xorshift lanes over 64-bit words
+// keep it close to memory speed, so verifying a multi-GB snapshot does not undo the point of loading one.
+static uint64_t snapshot_checksum(const void* data, size_t size, uint64_t seed) {
+    const uint64_t prime = 0x9e3779b97f4a7c15ULL;
+    uint64_t lane[4] = {seed, seed + prime, seed ^ 0xc2b2ae3d27d4eb4fULL, ~seed};
+    const unsigned char* p = data;
+    size_t left = size;
+    while (left >= 32) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t word;
+            memcpy(&word, p + 8 * i, sizeof(word));
+            lane[i] = (lane[i] ^ word) * prime;
+            lane[i] ^= lane[i] >> 29;
+        }
+        p += 32;
+        left -= 32;
+    }
+
+    uint64_t hash = size;
+    for (int i = 0; i < 4; i++) {
+        hash = (hash ^ lane[i]) * prime;
+        hash ^= hash >> 32;
+    }
+    for (; left > 0; left--, p++) {
+        hash = (hash ^ *p) * prime;
+    }
+    return hash ^ (hash >> 29);
+}
+
+// Section [offset, offset + size) of the file, with the zero padding up to it
+static bool write_section(FILE* out, uint64_t* position, uint64_t offset, const void* data, size_t size) {
+    static const char padding[SNAPSHOT_ALIGN];
+    if (offset - *position > 0 && fwrite(padding, 1, (size_t)(offset - *position), out) != offset - *position) {
+        return false;
+    }
+    if (size > 0 && fwrite(data, 1, size, out) != size) {
+        return false;
+    }
+    *position = offset + size;
+    return true;
+}
+
+// Write the booking table to path and copy the header written to *written. The file is written next to it
+// first, flushed to disk and renamed into place, so an interrupted save never leaves a half written snapshot.
+static bool write_snapshot(const char* path, SnapshotHeader* written) {
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = sizeof(SnapshotHeader);
+    header.name_length = MAX_NAME_LEN;
+    header.facility_name_length = MAX_FACILITY_NAME_LENGTH;
+    header.text_size = sizeof(BookingText);
+    header.booking_count = booking_count;
+    header.member_count = members.count;
+    header.facility_count = site.facility_count;
+
+    // Lay the sections out and checksum them in file order
+    uint64_t offset = align_offset(sizeof(SnapshotHeader));
+    header.facility_offset = offset;
+    header.checksum = snapshot_checksum(site.facility_names, (size_t)site.facility_count * MAX_FACILITY_NAME_LENGTH, 0);
+    offset = align_offset(offset + (uint64_t)site.facility_count * MAX_FACILITY_NAME_LENGTH);
+    header.member_offset = offset;
+    header.checksum = snapshot_checksum(members.names, (size_t)members.count * MAX_NAME_LEN, header.checksum);
+    offset = align_offset(offset + (uint64_t)members.count * MAX_NAME_LEN);
+    int column = 0;
+#define LAYOUT_COLUMN(name, type) \
+    header.column_offset[column++] = offset; \
+    header.checksum = snapshot_checksum(bookings.name, (size_t)booking_count * sizeof(type), header.checksum); \
+    offset = align_offset(offset + (uint64_t)booking_count * sizeof(type));
+    BOOKING_COLUMNS(LAYOUT_COLUMN)
+#undef LAYOUT_COLUMN
+    header.file_size = offset;
+
+    char temp_path[MAX_LINE + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* out = fopen(temp_path, "wb");
+    if (out == NULL) {
+        printf("Error: Cannot write snapshot file: %s\n", path);
+        return false;
+    }
+
+    uint64_t position = 0;
+    bool ok = write_section(out, &position, 0, &header, sizeof(header)) &&
+              write_section(out, &position, header.facility_offset, site.facility_names,
+                            (size_t)site.facility_count * MAX_FACILITY_NAME_LENGTH) &&
+              write_section(out, &position, header.member_offset, members.names, (size_t)members.count * MAX_NAME_LEN);
+    column = 0;
+#define WRITE_COLUMN(name, type) \
+    ok = ok && write_section(out, &position, header.column_offset[column++], bookings.name, \
+                             (size_t)booking_count * sizeof(type));
+    BOOKING_COLUMNS(WRITE_COLUMN)
+#undef WRITE_COLUMN
+    ok = ok && write_section(out, &position, header.file_size, NULL, 0);
+
+    ok = ok && fflush(out) == 0 && fsync(fileno(out)) == 0;
+    if (fclose(out) != 0 || !ok || rename(temp_path, path) != 0) {
+        printf("Error: Cannot write snapshot file: %s\n", path);
+        unlink(temp_path);
+        return false;
+    }
+    *written = header;
+    return true;
+}
+
+// saveSnapshot: write the booking table to path
+bool save_snapshot(const char* path) {
+    SnapshotHeader header;
+    if (!write_snapshot(path, &header)) return false;
+    printf("Snapshot saved: %d bookings, %d members.\n", booking_count, members.count);
+    return true;
+}
+
+// Everything about the file is checked before anything in the program changes
+static bool check_snapshot(const unsigned char* file, size_t size, const char* path) {
+    const SnapshotHeader* header = (const SnapshotHeader*)file;
+    if (size < sizeof(SnapshotHeader) || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        printf("Error: %s is not a snapshot file.\n", path);
+        return false;
+    }
+    if (header->version != SNAPSHOT_VERSION || header->header_size != sizeof(SnapshotHeader) ||
+        header->name_length != MAX_NAME_LEN || header->facility_name_length != MAX_FACILITY_NAME_LENGTH ||
+        header->text_size != sizeof(BookingText)) {
+        printf("Error: Snapshot %s was written by an incompatible version.\n", path);
+        return false;
+    }
+
+    // Sections in order, aligned, inside the file
+    uint64_t end = sizeof(SnapshotHeader);
+    uint64_t offsets[2 + NUM_BOOKING_COLUMNS], sizes[2 + NUM_BOOKING_COLUMNS];
+    int sections = 0;
+    bool ok = header->file_size == size && header->booking_count >= 0 && header->member_count >= 0 &&
+              header->facility_count >= 0 && header->facility_count <= MAX_SITE_FACILITIES;
+    offsets[sections] = header->facility_offset;
+    sizes[sections++] = (uint64_t)header->facility_count * MAX_FACILITY_NAME_LENGTH;
+    offsets[sections] = header->member_offset;
+    sizes[sections++] = (uint64_t)header->member_count * MAX_NAME_LEN;
+    int column = 0;
+#define SIZE_COLUMN(name, type) \
+    offsets[sections] = header->column_offset[column++]; \
+    sizes[sections++] = (uint64_t)header->booking_count * sizeof(type);
+    BOOKING_COLUMNS(SIZE_COLUMN)
+#undef SIZE_COLUMN
+    uint64_t checksum = 0;
+    for (int i = 0; ok && i < sections; i++) {
+        ok = offsets[i] >= end && offsets[i] % SNAPSHOT_ALIGN == 0 && offsets[i] <= size && sizes[i] <= size - offsets[i];
+        if (ok) {
+            checksum = snapshot_checksum(file + offsets[i], (size_t)sizes[i], checksum);
+            end = offsets[i] + sizes[i];
+        }
+    }
+    if (!ok || checksum != header->checksum) {
+        printf("Error: Snapshot %s is damaged (checksum or layout mismatch).\n", path);
+        return false;
+    }
+
+    // Names must be terminated, every booking must refer to a stored member and facility
+    const char* facility_names = (const char*)file + header->facility_offset;
+    const char* member_names = (const char*)file + header->member_offset;
+    for (int i = 0; ok && i < header->facility_count; i++) {
+        ok = memchr(facility_names + (size_t)i * MAX_FACILITY_NAME_LENGTH, '\0', MAX_FACILITY_NAME_LENGTH) != NULL;
+    }
+    for (int i = 0; ok && i < header->member_count; i++) {
+        ok = memchr(member_names + (size_t)i * MAX_NAME_LEN, '\0', MAX_NAME_LEN) != NULL;
+    }
+    const int* member = (const int*)(file + header->column_offset[COLUMN_member]);
+    const FacilityList* facilities = (const FacilityList*)(file + header->column_offset[COLUMN_facilities]);
+    for (int i = 0; ok && i < header->booking_count; i++) {
+        ok = member[i] >= 0 && member[i] < header->member_count && facilities[i].count <= MAX_FACILITIES;
+        for (int k = 0; ok && k < facilities[i].count; k++) {
+            ok = facilities[i].ids[k] < header->facility_count;
+        }
+    }
+    if (!ok) {
+        printf("Error: Snapshot %s is damaged (names or ids out of range).\n", path);
+        return false;
+    }
+
+    // Facilities the site does not stock are added with zero units, as when a booking names them
+    int unknown = 0;
+    for (int i = 0; i < header->facility_count; i++) {
+        if (facility_id(facility_names + (size_t)i * MAX_FACILITY_NAME_LENGTH) < 0) unknown++;
+    }
+    if (site.facility_count + unknown > MAX_SITE_FACILITIES) {
+        printf("Error: Too many different facility names.\n");
+        return false;
+    }
+    return true;
+}
+
+// loadSnapshot: replace the booking table with a saved one. The columns are used in place from a private
+// mapping of the file; only ids that differ between the saved and the current site or registry are rewritten.
+bool load_snapshot(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        printf("Error: Cannot open snapshot file: %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        printf("Error: %s is not a snapshot file.\n", path);
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    unsigned char* file = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    if (!check_snapshot(file, size, path)) {
+        munmap(file, size);
+        return false;
+    }
+    const SnapshotHeader* header = (const SnapshotHeader*)file;
+
+    // Saved facility and member ids -> current ones, matched by name
+    int facility_map[MAX_SITE_FACILITIES];
+    bool same_facilities = true;
+    for (int i = 0; i < header->facility_count; i++) {
+        facility_map[i] = intern_facility((const char*)file + header->facility_offset + (size_t)i * MAX_FACILITY_NAME_LENGTH);
+        same_facilities = same_facilities && facility_map[i] == i;
+    }
+
+    init_members(); // The replaced bookings' members go with them
+    int* member_map = malloc((size_t)(header->member_count > 0 ? header->member_count : 1) * sizeof(int));
+    if (member_map == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    bool same_members = true;
+    for (int i = 0; i < header->member_count; i++) {
+        member_map[i] = intern_member((const char*)file + header->member_offset + (size_t)i * MAX_NAME_LEN);
+        same_members = same_members && member_map[i] == i;
+    }
+
+    free_booking_columns();
+    int column = 0;
+#define MAP_COLUMN(name, type) bookings.name = (type*)(file + header->column_offset[column++]);
+    BOOKING_COLUMNS(MAP_COLUMN)
+#undef MAP_COLUMN
+    bookings.mapping = file;
+    bookings.mapped_size = size;
+    booking_count = header->booking_count;
+    booking_capacity = booking_count;
+
+    for (int i = 0; !same_members && i < booking_count; i++) {
+        bookings.member[i] = member_map[bookings.member[i]];
+    }
+    for (int i = 0; !same_facilities && i < booking_count; i++) {
+        FacilityList* facilities = &bookings.facilities[i];
+        bookings.facility_mask[i] = 0;
+        for (int k = 0; k < facilities->count; k++) {
+            facilities->ids[k] = (unsigned char)facility_map[facilities->ids[k]];
+            bookings.facility_mask[i] |= 1u << facilities->ids[k];
+        }
+    }
+    free(member_map);
+
+    invalidate_schedule_caches();
+    printf("Snapshot loaded: %d bookings, %d members.\n", booking_count, members.count);
+    return true;
+}
+
+// Write-Ahead Log Functions
+// Hand the buffered records to the kernel; after this only a crash of the machine can lose them
+static void wal_write_buffer() {
+    const char* data = (const char*)wal.buffer;
+    size_t left = (size_t)wal.buffered * sizeof(WalRecord);
+    while (left > 0) {
+        ssize_t written = write(wal.fd, data, left);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0) {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        data += written;
+        left -= (size_t)written;
+    }
+    wal.buffered = 0;
+}
+
+void wal_sync() {
+    if (wal.unsynced == 0) return;
+    STAT_START(started);
+    wal_write_buffer();
+    if (fdatasync(wal.fd) == -1) {
+        perror("fdatasync");
+        exit(EXIT_FAILURE);
+    }
+    wal.unsynced = 0;
+    stat_record(STAT_WAL_SYNC, 1, started);
+}
+
+static void wal_append(WalRecord* record) {
+    record->checksum = snapshot_checksum(&record->data, sizeof(record->data), record->kind);
+    if (wal.unsynced == 0) wal.first_unsynced = stat_clock();
+    wal.buffer[wal.buffered++] = *record;
+    wal.unsynced++;
+    if (wal.unsynced >= WAL_GROUP_RECORDS ||
+        stat_clock() - wal.first_unsynced >= WAL_SYNC_INTERVAL_MS * 1000000LL) {
+        wal_sync(); // The buffer holds one group, so it never overflows
+    }
+}
+
+void wal_append_booking(const Booking* b) {
+    WalRecord record;
+    memset(&record, 0, sizeof(record));
+    record.kind = WAL_RECORD_BOOKING;
+    record.data.add.booking = *b;
+    for (int k = 0; k < b->facilities.count; k++) {
+        strcpy(record.data.add.facility_names[k], site.facility_names[b->facilities.ids[k]]);
+    }
+    wal_append(&record);
+}
+
+static void wal_snapshot_path(char path[MAX_LINE + 16], uint32_t sequence) {
+    snprintf(path, MAX_LINE + 16, "%s.%u.snap", wal.path, (unsigned int)sequence);
+}
+
+static WalHeader wal_header() {
+    WalHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WAL_MAGIC, sizeof(header.magic));
+    header.version = WAL_VERSION;
+    header.record_size = sizeof(WalRecord);
+    return header;
+}
+
+// fsync the directory holding path, so a file renamed into it survives a crash
+static void sync_parent_directory(const char* path) {
+    char directory[MAX_LINE];
+    snprintf(directory, sizeof(directory), "%s", path);
+    char* slash = strrchr(directory, '/');
+    if (slash == NULL) {
+        strcpy(directory, ".");
+    } else {
+        slash[slash == directory] = '\0'; // Keep the "/" of the root
+    }
+    int fd = open(directory, O_RDONLY);
+    if (fd == -1 || fsync(fd) == -1) {
+        perror("fsync");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+}
+
+// loadSnapshot with -wal. The log cannot just name the loaded file, the user may change or delete it later.
+// Instead the loaded table is saved as the log's own snapshot and the log starts over with one record for it.
+// The new log replaces the old one in a single rename, and the old snapshot is only removed after that, so a
+// crash at any point leaves a complete log whose snapshot exists.
+void wal_checkpoint() {
+    WalRecord record;
+    memset(&record, 0, sizeof(record));
+    record.kind = WAL_RECORD_SNAPSHOT;
+    record.data.snapshot.sequence = wal.checkpoint + 1;
+    char snapshot_path[MAX_LINE + 16];
+    wal_snapshot_path(snapshot_path, record.data.snapshot.sequence);
+    SnapshotHeader snapshot;
+    if (!write_snapshot(snapshot_path, &snapshot)) {
+        printf("Error: Cannot checkpoint write-ahead log %s, the loaded snapshot would not survive a restart.\n", wal.path);
+        exit(EXIT_FAILURE);
+    }
+    record.data.snapshot.size = snapshot.file_size;
+    record.data.snapshot.checksum = snapshot.checksum;
+    record.checksum = snapshot_checksum(&record.data, sizeof(record.data), record.kind);
+
+    char temp_path[MAX_LINE + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", wal.path);
+    WalHeader header = wal_header();
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1 || write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+        write(fd, &record, sizeof(record)) != (ssize_t)sizeof(record) || fdatasync(fd) == -1 ||
+        rename(temp_path, wal.path) == -1) {
+        perror("write-ahead log checkpoint");
+        exit(EXIT_FAILURE);
+    }
+    sync_parent_directory(wal.path);
+
+    // Records not written yet describe the table the snapshot replaced
+    close(wal.fd);
+    wal.fd = fd;
+    wal.buffered = 0;
+    wal.unsynced = 0;
+    if (wal.checkpoint > 0) {
+        wal_snapshot_path(snapshot_path, wal.checkpoint);
+        unlink(snapshot_path);
+    }
+    wal.checkpoint = record.data.snapshot.sequence;
+}
+
+// Called when the input goes idle. Records so far are written out at once; the fdatasync may wait until
+// the group's deadline in case more input arrives. Returns the ms left until then, -1 when nothing is pending.
+int wal_idle() {
+    if (wal.unsynced == 0) return -1;
+    wal_write_buffer();
+    long long waited_ms = (stat_clock() - wal.first_unsynced) / 1000000;
+    if (waited_ms >= WAL_SYNC_INTERVAL_MS) {
+        wal_sync();
+        return -1;
+    }
+    return (int)(WAL_SYNC_INTERVAL_MS - waited_ms);
+}
+
+// Before the input reader blocks: sync now if the input stays quiet until the group's deadline
+void wal_wait_for_input(int input_fd) {
+    int timeout = wal_idle();
+    struct pollfd input = {.fd = input_fd, .events = POLLIN};
+    if (timeout >= 0 && poll(&input, 1, timeout) == 0) {
+        wal_sync();
+    }
+}
+
+// The log's own snapshot, if it is still the file the checkpoint wrote
+static bool wal_snapshot_matches(const char* path, uint64_t size, uint64_t checksum) {
+    SnapshotHeader header;
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    bool ok = fd != -1 && fstat(fd, &st) == 0 && (uint64_t)st.st_size == size &&
+              pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && header.checksum == checksum;
+    if (fd != -1) close(fd);
+    return ok;
+}
+
+static bool wal_replay_record(const WalRecord* record) {
+    if (record->kind == WAL_RECORD_SNAPSHOT) {
+        char path[MAX_LINE + 16];
+        wal_snapshot_path(path, record->data.snapshot.sequence);
+        if (!wal_snapshot_matches(path, record->data.snapshot.size, record->data.snapshot.checksum)) {
+            printf("Error: Snapshot %s of the write-ahead log is missing or was changed.\n", path);
+            return false;
+        }
+        if (!load_snapshot(path)) return false;
+        wal.checkpoint = record->data.snapshot.sequence;
+        return true;
+    }
+
+    Booking b = record->data.add.booking;
+    b.facility_mask = 0;
+    for (int k = 0; k < b.facilities.count; k++) {
+        int id = intern_facility(record->data.add.facility_names[k]);
+        if (id < 0) {
+            printf("Error: Too many different facility names.\n");
+            return false;
+        }
+        b.facilities.ids[k] = (unsigned char)id;
+        b.facility_mask |= 1u << id;
+    }
+    b.member = intern_member(b.text.client);
+    append_booking(&b);
+    return true;
+}
+
+// -wal: replay the log into the booking table, then keep appending to it. A torn record at the end,
+// left by a crash in the middle of a write, is cut off so new records follow the last complete one.
+// A complete record that cannot be replayed stops the program and leaves the log as it is.
+bool wal_open(const char* path) {
+    if (strlen(path) >= sizeof(wal.path)) {
+        printf("Error: Write-ahead log path is too long: %s\n", path);
+        return false;
+    }
+    strcpy(wal.path, path);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+        printf("Error: Cannot open write-ahead log: %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("fstat");
+        exit(EXIT_FAILURE);
+    }
+
+    WalHeader header;
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        header = wal_header();
+        if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) || fdatasync(fd) == -1) {
+            printf("Error: Cannot write write-ahead log: %s\n", path);
+            close(fd);
+            return false;
+        }
+        size = sizeof(header);
+    }
+
+    const unsigned char* file = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (file == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&header, file, size < sizeof(header) ? size : sizeof(header));
+    if (size < sizeof(header) || memcmp(header.magic, WAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != WAL_VERSION || header.record_size != sizeof(WalRecord)) {
+        printf("Error: %s is not a write-ahead log of this version.\n", path);
+        munmap((void*)file, size);
+        close(fd);
+        return false;
+    }
+
+    // Records are fixed size, so replay is a straight walk over the mapping
+    const WalRecord* records = (const WalRecord*)(file + sizeof(header));
+    int count = (int)((size - sizeof(header)) / sizeof(WalRecord));
+    reserve_bookings(booking_count + count);
+    int replayed = 0;
+    while (replayed < count) {
+        const WalRecord* record = &records[replayed];
+        if ((record->kind != WAL_RECORD_BOOKING && record->kind != WAL_RECORD_SNAPSHOT) ||
+            record->checksum != snapshot_checksum(&record->data, sizeof(record->data), record->kind)) {
+            break;
+        }
+        if (!wal_replay_record(record)) {
+            printf("Error: Cannot replay write-ahead log %s, it is left unchanged.\n", path);
+            munmap((void*)file, size);
+            close(fd);
+            return false;
+        }
+        replayed++;
+    }
+    munmap((void*)file, size);
+
+    off_t end = (off_t)(sizeof(header) + (size_t)replayed * sizeof(WalRecord));
+    if ((size_t)end != size) {
+        printf("Error: Discarding %ld damaged bytes at the end of write-ahead log %s.\n", (long)(size - (size_t)end), path);
+        if (ftruncate(fd, end) == -1 || fdatasync(fd) == -1) {
+            perror("ftruncate");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (lseek(fd, end, SEEK_SET) == -1) {
+        perror("lseek");
+        exit(EXIT_FAILURE);
+    }
+
+    wal.buffer = malloc(WAL_GROUP_RECORDS * sizeof(WalRecord));
+    if (wal.buffer == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    wal.fd = fd;
+    if (replayed > 0) {
+        printf("Recovered %d bookings from write-ahead log %s.\n", booking_count, path);
+    }
+    return true;
+}
+
+void wal_close() {
+    if (wal.fd == -1) return;
+    wal_sync();
+    close(wal.fd);
+    free(wal.buffer);
+    wal.fd = -1;
+}
+
+// Input Functions
+void line_reader_init(LineReader* reader, int fd) {
+    reader->fd = fd;
+    reader->buffer = NULL;
+    reader->capacity = 0;
+    reader->buffer = grow_array(reader->buffer, &reader->capacity, INPUT_BUFFER_SIZE, 1);
+    reader->start = 0;
+    reader->end = 0;
+    reader->eof = false;
+}
+
+void line_reader_free(LineReader* reader) {
+    free(reader->buffer);
+}
+
+// Next line without its '\n', NUL terminated in place; NULL at end of input. The pointer is valid until the next call.
+char* line_reader_next(LineReader* reader, int* length) {
+    while (1) {
+        char* line = reader->buffer + reader->start;
+        char* newline = memchr(line, '\n', (size_t)(reader->end - reader->start));
+        if (newline != NULL) {
+            *newline = '\0';
+            *length = (int)(newline - line);
+            reader->start += *length + 1;
+            return line;
+        }
+
+        if (reader->eof) {
+            if (reader->start == reader->end) return NULL;
+            // Last line without a trailing newline, there is always a spare byte for its terminator
+            *length = reader->end - reader->start;
+            line[*length] = '\0';
+            reader->start = reader->end;
+            return line;
+        }
+
+        // Move the partial line to the front and refill; grow only if one line fills the whole buffer
+        memmove(reader->buffer, line, (size_t)(reader->end - reader->start));
+        reader->end -= reader->start;
+        reader->start = 0;
+        if (reader->end + 1 >= reader->capacity) {
+            reader->buffer = grow_array(reader->buffer, &reader->capacity, reader->capacity + 1, 1);
+        }
+
+        if (wal.unsynced > 0) wal_wait_for_input(reader->fd);
+        ssize_t got = read(reader->fd, reader->buffer + reader->end, (size_t)(reader->capacity - reader->end - 1));
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) perror("read");
+        if (got <= 0) {
+            reader->eof = true;
+        } else {
+            reader->end += (int)got;
+        }
+    }
+}
+
+// IPC Functions
+// Create the pipe and a shared mapping big enough for one record per booking; call before fork
+void open_schedule_channel(ScheduleChannel* channel, int capacity) {
+    if (pipe(channel->pipe_fd) == -1) {
+        perror("pipe error");
+        exit(EXIT_FAILURE);
+    }
+
+    channel->mapped_size = sizeof(ScheduleMapping) + (size_t)(capacity > 0 ? capacity : 1) * sizeof(ScheduleRecord);
+    channel->shared = mmap(NULL, channel->mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (channel->shared == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void close_schedule_channel(ScheduleChannel* channel) {
+    munmap(channel->shared, channel->mapped_size);
+    channel->shared = NULL;
+}
+
+void record_writer_init(RecordWriter* writer, ScheduleChannel* channel) {
+    writer->fd = channel->pipe_fd[1];
+    writer->records = channel->shared->records;
+    writer->count = 0;
+#ifdef DEBUG_TEXT_IPC
+    writer->used = 0;
+#endif
+}
+
+// Write a whole buffer to fd, retrying short writes
+static void write_fully(int fd, const void* data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = write(fd, (const char*)data + written, size - written);
+        if (n == -1) {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        written += (size_t)n;
+    }
+}
+
+// Write a whole buffer to the scheduler -> reporter pipe
+static void pipe_write(int fd, const void* data, size_t size) {
+    STAT_START(started);
+    write_fully(fd, data, size);
+    STAT_END(STAT_PIPE_WRITE, started);
+}
+
+#ifndef DEBUG_TEXT_IPC
+// Read exactly size bytes, false if the pipe closed first
+static bool read_fully(int fd, void* data, size_t size) {
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = read(fd, (char*)data + got, size - got);
+        if (n <= 0) return false;
+        got += (size_t)n;
+    }
+    return true;
+}
+#endif
+
+// Hand the finished schedule to the child: one completion notice carrying the record count
+void record_writer_finish(RecordWriter* writer) {
+#ifdef DEBUG_TEXT_IPC
+    pipe_write(writer->fd, writer->buffer, writer->used);
+    writer->used = 0;
+#else
+    pipe_write(writer->fd, &writer->count, sizeof(writer->count));
+#endif
+}
+
+// Record one scheduling decision for the printBookings child
+void emit_schedule(RecordWriter* writer, const Schedule* s) {
+#ifdef DEBUG_TEXT_IPC
+    const BookingText* text = &bookings.text[s->id];
+    const FacilityList* facilities = &bookings.facilities[s->id];
+    char buffer[IPC_LINE_SIZE]; // Every field fits at its longest, the checks only keep a bad field in bounds
+    int len = snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d", s->id, text->client, text->type,
+                       text->date, text->time, bookings.duration[s->id], facilities->count);
+    for (int k = 0; k < facilities->count && len < (int)sizeof(buffer); k++) {
+        len += snprintf(buffer + len, sizeof(buffer) - len, " %s", site.facility_names[facilities->ids[k]]);
+    }
+    if (len < (int)sizeof(buffer)) {
+        len += snprintf(buffer + len, sizeof(buffer) - len, " %d %s\n", s->parking_slot, record_status_names[s->status]);
+    }
+    if (len >= (int)sizeof(buffer)) {
+        len = (int)sizeof(buffer) - 1;
+        buffer[len - 1] = '\n';
+    }
+    if (writer->used + (size_t)len > sizeof(writer->buffer)) {
+        pipe_write(writer->fd, writer->buffer, writer->used);
+        writer->used = 0;
+    }
+    memcpy(writer->buffer + writer->used, buffer, (size_t)len);
+    writer->used += (size_t)len;
+#else
+    ScheduleRecord* record = &writer->records[writer->count++];
+    record->id = s->id;
+    record->parking_slot = s->parking_slot;
+    record->start_time = s->start_time;
+    record->end_time = s->end_time;
+    record->facility_mask = bookings.facility_mask[s->id];
+    record->status = s->status;
+#endif
+}
+
+// Calendar Functions
+// Put the given bookings in calendar order and group them by day. latest_end is the latest end time of
+// everything scheduled before these bookings, so the first day knows whether it starts with every bay free.
+void build_calendar_index(CalendarIndex* calendar, const int* indices, int count, SortOrder order, int latest_end) {
+    int n = count;
+    SortKey* keys = malloc((size_t)(n > 0 ? n : 1) * sizeof(SortKey));
+    calendar->entries = malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    calendar->days = malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    calendar->offsets = malloc((size_t)(n + 1) * sizeof(int));
+    calendar->independent = malloc((size_t)(n > 0 ? n : 1) * sizeof(bool));
+    if (keys == NULL || calendar->entries == NULL || calendar->days == NULL ||
+        calendar->offsets == NULL || calendar->independent == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    STAT_START(sort_started);
+    for (int i = 0; i < n; i++) {
+        calendar_sort_key(&keys[i], indices[i], order);
+    }
+    merge_sort_keys(keys, n);
+    STAT_END(STAT_SORT, sort_started);
+
+    // One group per distinct day; a day is independent when nothing booked earlier runs past its midnight
+    calendar->day_count = 0;
+    for (int i = 0; i < n; i++) {
+        int b = keys[i].index;
+        int day = bookings.start_minute[b] / MINUTES_PER_DAY;
+        calendar->entries[i] = b;
+        if (i == 0 || day != calendar->days[calendar->day_count - 1]) {
+            int d = calendar->day_count++;
+            calendar->days[d] = day;
+            calendar->offsets[d] = i;
+            calendar->independent[d] = latest_end <= day * MINUTES_PER_DAY;
+        }
+        if (bookings.end_minute[b] > latest_end) {
+            latest_end = bookings.end_minute[b];
+        }
+    }
+    calendar->offsets[calendar->day_count] = n;
+    free(keys);
+}
+
+void free_calendar_index(CalendarIndex* calendar) {
+    free(calendar->entries);
+    free(calendar->days);
+    free(calendar->offsets);
+    free(calendar->independent);
+}
+
+#ifndef DEBUG_TEXT_IPC
+// Count already decided records in the context's summary
+static void add_records_to_context(SchedulerContext* ctx, const ScheduleRecord* records, int count) {
+    for (int i = 0; i < count; i++) {
+        ctx->summary[0]++;
+        ctx->summary[(records[i].status == RECORD_SCHEDULED) ? 1 : 2]++;
+    }
+}
+#endif
+
+// Schedule days [first, last). An independent day starts with every bay and facility free, otherwise bays and
+// facilities still held by bookings from the night before carry over through the allocator and the timeline.
+static void schedule_day_range(SchedulerContext* ctx, SlotAllocator* slots, RecordWriter* writer,
+                               const CalendarIndex* calendar, int first, int last, DayScheduler schedule_day) {
+    for (int d = first; d < last; d++) {
+        if (calendar->independent[d]) {
+            slot_allocator_reset(slots);
+            ctx->facilities.carried_count = 0;
+        }
+        facility_timeline_start_day(&ctx->facilities, calendar->days[d] * MINUTES_PER_DAY);
+
+        int begin = calendar->offsets[d];
+        schedule_day(ctx, slots, writer, calendar->entries + begin, calendar->offsets[d + 1] - begin);
+    }
+}
+
+#ifndef DEBUG_TEXT_IPC
+// Spread runs of days over forked workers, cutting only at independent days so the result is the same as
+// scheduling them one after another. Every booking produces exactly one record, so each worker writes its
+// days' records straight into their final place in the shared mapping. Returns false if not worth it.
+static bool schedule_days_in_parallel(SchedulerContext* ctx, SlotAllocator* slots, RecordWriter* writer,
+                                      const CalendarIndex* calendar, DayScheduler schedule_day) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_workers = (cpus > MAX_DAY_WORKERS) ? MAX_DAY_WORKERS : (int)cpus;
+    if (max_workers < 2 || calendar->day_count < 2) return false;
+
+    pid_t workers[MAX_DAY_WORKERS];
+    int worker_count = 0;
+    int base = writer->count; // Records before the calendar's first day are already in place
+    int total = calendar->offsets[calendar->day_count];
+    int target = total / max_workers + 1;
+    int first = 0;
+
+    fflush(stdout);
+    for (int d = 1; d <= calendar->day_count; d++) {
+        bool cut = (d == calendar->day_count) ||
+                   (calendar->independent[d] && calendar->offsets[d] - calendar->offsets[first] >= target &&
+                    worker_count < max_workers - 1);
+        if (!cut) continue;
+
+        stats_flush();
+        workers[worker_count] = fork();
+        if (workers[worker_count] == -1) {
+            perror("fork error");
+            exit(EXIT_FAILURE);
+        }
+        if (workers[worker_count] == 0) {
+            // The first worker continues from the bays as they are, every later one starts on an independent day
+            writer->count = base + calendar->offsets[first];
+            schedule_day_range(ctx, slots, writer, calendar, first, d, schedule_day);
+            stats_flush();
+            exit(0);
+        }
+        worker_count++;
+        first = d;
+    }
+
+    for (int i = 0; i < worker_count; i++) {
+        waitpid(workers[i], NULL, 0);
+    }
+
+    // The workers' counters stayed in their own processes, so rebuild them from the records
+    add_records_to_context(ctx, writer->records + base, total);
+    writer->count = base + total;
+    return true;
+}
+
+// Schedule cache functions
+// Keep records [from, count) as the algorithm's latest schedule; records before from are already cached
+void schedule_cache_store(ScheduleCache* cache, const ScheduleRecord* records, int from, int count) {
+    int capacity = cache->capacity; // Both arrays grow in step
+    cache->records = grow_array(cache->records, &capacity, count + 1, sizeof(ScheduleRecord));
+    cache->latest_end = grow_array(cache->latest_end, &cache->capacity, count + 1, sizeof(int));
+
+    memcpy(cache->records + from, records + from, (size_t)(count - from) * sizeof(ScheduleRecord));
+    if (from == 0) cache->latest_end[0] = 0;
+    for (int i = from; i < count; i++) {
+        int end = cache->records[i].end_time;
+        cache->latest_end[i + 1] = (end > cache->latest_end[i]) ? end : cache->latest_end[i];
+    }
+    cache->booking_count = count;
+    if (cache->occupancy != NULL) occupancy_update(cache->occupancy, cache, from);
+}
+
+// Number of cached records on days before day (records are in day order)
+static int cached_records_before_day(const ScheduleCache* cache, int day) {
+    int lo = 0, hi = cache->booking_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cache->records[mid].start_time / MINUTES_PER_DAY < day) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Put the bays and facilities back the way they were after the first kept records: every bay was last reset at
+// the start of the latest independent day, and since then each one is busy until the latest booking assigned
+// to it ends. Facilities are held by the bookings accepted since then; the timeline drops the ones that ended.
+static void restore_allocations(SchedulerContext* ctx, SlotAllocator* slots, const ScheduleCache* cache, int kept) {
+    int reset = kept;
+    while (reset > 0) {
+        reset--;
+        int day = cache->records[reset].start_time / MINUTES_PER_DAY;
+        bool first_of_day = (reset == 0) || (cache->records[reset - 1].start_time / MINUTES_PER_DAY != day);
+        if (first_of_day && cache->latest_end[reset] <= day * MINUTES_PER_DAY) break;
+    }
+
+    // Rescheduling starts after the last kept record's day, bookings ending by then hold no facility any more
+    int carry_from = (kept > 0) ? (cache->records[kept - 1].start_time / MINUTES_PER_DAY + 1) * MINUTES_PER_DAY : 0;
+
+    // A bay only takes a booking starting after its previous one ended, so the last assignment is the latest
+    for (int i = reset; i < kept; i++) {
+        const ScheduleRecord* rec = &cache->records[i];
+        if (rec->status != RECORD_SCHEDULED) continue;
+        slot_allocator_assign(slots, rec->parking_slot - 1, rec->end_time);
+        if (rec->end_time > carry_from) {
+            FacilityTimeline* timeline = &ctx->facilities;
+            timeline->carried = grow_array(timeline->carried, &timeline->carried_capacity, timeline->carried_count + 1, sizeof(int));
+            timeline->carried[timeline->carried_count++] = rec->id;
+        }
+    }
+}
+#endif
+
+// The booking table was replaced, so no cached record describes it any more
+void invalidate_schedule_caches() {
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        schedule_caches[i].booking_count = 0;
+        if (schedule_caches[i].occupancy != NULL) occupancy_update(schedule_caches[i].occupancy, &schedule_caches[i], 0);
+    }
+}
+
+// Keep the schedule a run just handed over through channel as the algorithm's cache. Only the records after the
+// ones the run took from the cache are copied, and the occupancy index is updated from the first new day on.
+void store_schedule(ScheduleCache* cache, const ScheduleChannel* channel) {
+#ifndef DEBUG_TEXT_IPC
+    schedule_cache_store(cache, channel->shared->records, channel->shared->kept, booking_count);
+#else
+    (void)cache;
+    (void)channel;
+#endif
+}
+
+// Occupancy Index Functions
+// Number of values in sorted[0 .. count) that are below value (or not above it, with or_equal)
+static int count_before(const int* sorted, int count, int value, bool or_equal) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (sorted[mid] < value || (or_equal && sorted[mid] == value)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Number of days in the index before day
+static int occupancy_days_before(const OccupancyIndex* index, int day) {
+    int lo = 0, hi = index->day_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (index->days[mid].day < day) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Append a day from the accepted records still running at its midnight or starting on it (running, indices into
+// records): the bays they hold and the facilities over the day's timeline window, clipped like timeline_range
+static void occupancy_add_day(OccupancyIndex* index, int day, const ScheduleRecord* records, const int* running, int running_count) {
+    index->days = grow_array(index->days, &index->day_capacity, index->day_count + 1, sizeof(OccupancyDay));
+    index->busy_until = grow_array(index->busy_until, &index->busy_capacity, index->busy_count + running_count, sizeof(int));
+    index->scratch = grow_array(index->scratch, &index->scratch_capacity, 4 * MAX_FACILITIES * running_count, sizeof(SortKey));
+    OccupancyDay* entry = &index->days[index->day_count];
+    entry->day = day;
+
+    // A bay only takes a booking that starts after its last one ended, so its latest running booking sets its free_at
+    for (int r = 0; r < running_count; r++) {
+        index->scratch[r] = (SortKey){records[running[r]].parking_slot, records[running[r]].end_time, 0};
+    }
+    merge_sort_keys(index->scratch, running_count);
+    int busy = 0;
+    for (int r = 0; r < running_count; r++) {
+        if (r + 1 == running_count || index->scratch[r + 1].primary != index->scratch[r].primary) {
+            index->scratch[busy++] = (SortKey){index->scratch[r].secondary, 0, 0};
+        }
+    }
+    merge_sort_keys(index->scratch, busy);
+    entry->busy_first = index->busy_count;
+    for (int b = 0; b < busy; b++) {
+        index->busy_until[index->busy_count++] = index->scratch[b].primary;
+    }
+    entry->busy_last = index->busy_count;
+
+    // One event where each running booking starts holding its facilities and one where it stops
+    int day_start = day * MINUTES_PER_DAY;
+    int event_count = 0;
+    for (int r = 0; r < running_count; r++) {
+        const ScheduleRecord* rec = &records[running[r]];
+        int ids[2 * MAX_FACILITIES], units[2 * MAX_FACILITIES];
+        int count = facility_demand(&bookings.facilities[rec->id], ids, units);
+        int from = (rec->start_time > day_start) ? rec->start_time : day_start;
+        int to = (rec->end_time < day_start + MINUTES_PER_DAY + 1) ? rec->end_time : day_start + MINUTES_PER_DAY + 1;
+        for (int k = 0; k < count; k++) {
+            index->scratch[event_count++] = (SortKey){ids[k], from, units[k]};
+            index->scratch[event_count++] = (SortKey){ids[k], to, -units[k]};
+        }
+    }
+    merge_sort_keys(index->scratch, event_count);
+
+    // Each facility's events become its steps and their max tree
+    int capacity_steps = index->step_capacity;
+    index->step_time = grow_array(index->step_time, &capacity_steps, index->step_count + event_count, sizeof(int));
+    index->step_in_use = grow_array(index->step_in_use, &index->step_capacity, index->step_count + event_count, sizeof(int));
+    index->step_max = grow_array(index->step_max, &index->max_capacity, 2 * (index->step_count + event_count), sizeof(int));
+    int e = 0;
+    for (int f = 0; f < MAX_SITE_FACILITIES; f++) {
+        int first = index->step_count, level = 0;
+        entry->steps[f] = first;
+        for (; e < event_count && index->scratch[e].primary == f; e++) {
+            level += index->scratch[e].index;
+            if (index->step_count == first || index->step_time[index->step_count - 1] != index->scratch[e].secondary) {
+                index->step_time[index->step_count++] = index->scratch[e].secondary;
+            }
+            index->step_in_use[index->step_count - 1] = level;
+        }
+
+        int n = index->step_count - first;
+        if (n == 0) continue;
+        int* tree = index->step_max + 2 * first;
+        memcpy(tree + n, index->step_in_use + first, (size_t)n * sizeof(int));
+        for (int i = n - 1; i > 0; i--) {
+            tree[i] = (tree[2 * i] > tree[2 * i + 1]) ? tree[2 * i] : tree[2 * i + 1];
+        }
+    }
+    entry->steps[MAX_SITE_FACILITIES] = index->step_count;
+    index->day_count++;
+}
+
+// Bring the index in line with the cache after its records [from, booking_count) changed. Days before the first
+// changed record's day only depend on the records before it and stay; the index goes on from the last of them.
+void occupancy_update(OccupancyIndex* index, const ScheduleCache* cache, int from) {
+    const ScheduleRecord* records = cache->records;
+    int count = cache->booking_count;
+    if (from == count && from > 0) return;
+
+    int first_day = (from < count) ? records[from].start_time / MINUTES_PER_DAY : 0;
+    int kept = (from > 0) ? occupancy_days_before(index, first_day) : 0;
+    index->day_count = kept;
+    index->step_count = (kept > 0) ? index->days[kept - 1].steps[MAX_SITE_FACILITIES] : 0;
+    index->busy_count = (kept > 0) ? index->days[kept - 1].busy_last : 0;
+
+    // The accepted bookings still running at first_day
+    int* running = NULL;
+    int running_count = 0, running_capacity = 0;
+    for (int i = from - 1; i >= 0 && cache->latest_end[i + 1] > first_day * MINUTES_PER_DAY; i--) {
+        if (records[i].status == RECORD_SCHEDULED && records[i].end_time > first_day * MINUTES_PER_DAY) {
+            running = grow_array(running, &running_capacity, running_count + 1, sizeof(int));
+            running[running_count++] = i;
+        }
+    }
+
+    int day = first_day;
+    int i = from;
+    while (i < count || running_count > 0) {
+        for (; i < count && records[i].start_time / MINUTES_PER_DAY == day; i++) {
+            if (records[i].status != RECORD_SCHEDULED) continue;
+            running = grow_array(running, &running_capacity, running_count + 1, sizeof(int));
+            running[running_count++] = i;
+        }
+        occupancy_add_day(index, day, records, running, running_count);
+
+        // Bookings still running at the next midnight carry it into the index even if nothing starts on it
+        int next_midnight = (day + 1) * MINUTES_PER_DAY;
+        int still = 0;
+        for (int r = 0; r < running_count; r++) {
+            if (records[running[r]].end_time > next_midnight) running[still++] = running[r];
+        }
+        running_count = still;
+        day = (running_count > 0 || i == count) ? day + 1 : records[i].start_time / MINUTES_PER_DAY;
+    }
+    free(running);
+}
+
+// Most units of one facility in use at any minute of [from, to), from the steps [first, last) of the index
+static int occupancy_usage(const OccupancyIndex* index, int first, int last, int from, int to) {
+    const int* time = index->step_time + first;
+    const int* tree = index->step_max + 2 * first;
+    int n = last - first;
+    int at_from = count_before(time, n, from, true);
+    int most = (at_from > 0) ? index->step_in_use[first + at_from - 1] : 0;
+
+    // Steps starting inside the range
+    for (int l = at_from + n, r = count_before(time, n, to, false) + n; l < r; l /= 2, r /= 2) {
+        if (l & 1) {
+            if (tree[l] > most) most = tree[l];
+            l++;
+        }
+        if (r & 1) {
+            r--;
+            if (tree[r] > most) most = tree[r];
+        }
+    }
+    return most;
+}
+
+// queryAvailability -YYYY-MM-DD hh:mm n.n [facilities]; tells whether FCFS would accept the booking if it were
+// added now, from the bays and facilities the FCFS schedule of every booking so far leaves on that day
+void query_availability(char* args) {
+    char* cursor = args;
+    char *date, *time, *duration, *end;
+    int date_len = next_token(&cursor, &date);
+    int time_len = next_token(&cursor, &time);
+    int duration_len = next_token(&cursor, &duration);
+    float hours = (duration_len > 0) ? strtof(duration, &end) : 0.0f;
+    int day = (date_len > 1 && date[0] == '-') ? convert_date_to_days(date + 1) : -1;
+    int minute = (time_len > 0) ? convert_time_to_minutes(time) : -1;
+    if (day < 0 || minute < 0 || duration_len == 0 || end != duration + duration_len || !valid_duration(hours)) {
+        printf("Error: Invalid queryAvailability command format.\n"
+               "Usage: queryAvailability -YYYY-MM-DD hh:mm n.n [facilities];\n");
+        return;
+    }
+
+    FacilityList wanted = {.count = 0};
+    char* facility;
+    while (next_token(&cursor, &facility) > 0) {
+        int id = facility_id(facility);
+        if (id < 0) {
+            printf("Error: Unknown facility %s\n", facility);
+            return;
+        }
+        if (wanted.count == MAX_FACILITIES) {
+            printf("Error: At most %d facilities per query\n", MAX_FACILITIES);
+            return;
+        }
+        wanted.ids[wanted.count++] = (unsigned char)id;
+    }
+
+    update_fcfs_schedule();
+
+    // A new booking is decided after every booking of its day, so it sees the bays and facilities as that day
+    // left them. A day missing from the index has nothing running into it: every bay and facility is free.
+    int start = day * MINUTES_PER_DAY + minute;
+    int finish = start + (int)(hours * 60.0f + 0.5f);
+    int before = occupancy_days_before(&fcfs_occupancy, day + 1);
+    const OccupancyDay* entry = (before > 0 && fcfs_occupancy.days[before - 1].day == day) ? &fcfs_occupancy.days[before - 1] : NULL;
+    int free_bays = site.bay_count;
+    if (entry != NULL) {
+        int busy = entry->busy_last - entry->busy_first;
+        free_bays -= busy - count_before(fcfs_occupancy.busy_until + entry->busy_first, busy, start, true);
+    }
+    bool available = free_bays > 0;
+
+    printf("Availability on %s %s - %02d:%02d:\n", date + 1, time, (finish - day * MINUTES_PER_DAY) / 60, finish % 60);
+    printf("  %-12s %d of %d free\n", "bays", free_bays, site.bay_count);
+    int ids[2 * MAX_FACILITIES], units[2 * MAX_FACILITIES];
+    int count = facility_demand(&wanted, ids, units);
+    int until = (finish < (day + 1) * MINUTES_PER_DAY + 1) ? finish : (day + 1) * MINUTES_PER_DAY + 1;
+    for (int k = 0; k < count; k++) {
+        int in_use = (entry != NULL) ? occupancy_usage(&fcfs_occupancy, entry->steps[ids[k]], entry->steps[ids[k] + 1], start, until) : 0;
+        int left = site.facility_capacity[ids[k]] - in_use;
+        printf("  %-12s %d of %d free, %d needed\n", site.facility_names[ids[k]], left, site.facility_capacity[ids[k]], units[k]);
+        if (left < units[k]) available = false;
+    }
+    printf("Result: %s\n", available ? "Available" : "Not available");
+
+#ifdef DEBUG_TEXT_IPC
+    printf("Note: the -DDEBUG_TEXT_IPC build keeps no schedule, so no booking is counted.\n");
+#endif
+}
+
+// Shared driver: walk the calendar day by day and let schedule_day decide each day's bookings.
+// Days before the first day touched by bookings added since the cached schedule keep their cached records,
+// everything from that day on is scheduled again. The cache is only read; returns how many leading records were
+// taken from it. With cache NULL (and in the -DDEBUG_TEXT_IPC build) everything is scheduled and nothing is kept.
+// Busy runs of days are spread over forked workers only with may_fork, which needs writer's records to be shared.
+static int schedule_days_into(SchedulerContext* ctx, RecordWriter* writer, SortOrder order, DayScheduler schedule_day,
+                              const ScheduleCache* cache, bool may_fork) {
+    SlotAllocator slots;
+    slot_allocator_init(&slots, site.bay_count);
+
+    int cached = 0; // Bookings [0, cached) are in the cache
+    int kept = 0;   // Leading cached records that stay valid
+    int latest_end = 0;
+#ifndef DEBUG_TEXT_IPC
+    if (cache != NULL && cache->booking_count > 0 && cache->booking_count <= booking_count) {
+        cached = cache->booking_count;
+        int first_day = INF;
+        for (int i = cached; i < booking_count; i++) {
+            int day = bookings.start_minute[i] / MINUTES_PER_DAY;
+            if (day < first_day) first_day = day;
+        }
+        kept = cached_records_before_day(cache, first_day);
+        latest_end = cache->latest_end[kept];
+        restore_allocations(ctx, &slots, cache, kept);
+
+        memcpy(writer->records, cache->records, (size_t)kept * sizeof(ScheduleRecord));
+        writer->count = kept;
+        add_records_to_context(ctx, writer->records, kept);
+    }
+#else
+    (void)cache;
+    (void)may_fork;
+#endif
+
+    // Reschedule the dropped cached records together with the new bookings
+    int pending_count = (cached - kept) + (booking_count - cached);
+    int* pending = malloc((size_t)(pending_count > 0 ? pending_count : 1) * sizeof(int));
+    if (pending == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = kept; i < cached; i++) {
+        pending[i - kept] = cache->records[i].id;
+    }
+    for (int i = cached; i < booking_count; i++) {
+        pending[(cached - kept) + (i - cached)] = i;
+    }
 
-        if (facility_index == -1 || temp_availability[facility_index] <= 0) {
-            return false; 
-        }
+    CalendarIndex calendar;
+    build_calendar_index(&calendar, pending, pending_count, order, latest_end);
+    free(pending);
 
-        // Reserve the facility and its pair
-        temp_availability[facility_index]--;
-        if (facility_index % 2 == 0) { // Pairing logic: battery + cable, locker + umbrella, etc according to rules.
-            temp_availability[facility_index + 1]--;
-        } else {
-            temp_availability[facility_index - 1]--;
-        }
+    bool done = false;
+#ifndef DEBUG_TEXT_IPC
+    if (may_fork && pending_count >= PARALLEL_DAYS_MIN_BOOKINGS) {
+        done = schedule_days_in_parallel(ctx, &slots, writer, &calendar, schedule_day);
+    }
+#endif
+    if (!done) {
+        schedule_day_range(ctx, &slots, writer, &calendar, 0, calendar.day_count, schedule_day);
     }
 
-    // Reserve facilities
-    memcpy(facility_availability, temp_availability, sizeof(facility_availability));
-    return true;
+    slot_allocator_free(&slots);
+    free_calendar_index(&calendar);
+    return kept;
 }
 
-void release_facilities(Booking* b) {
-    for (int i = 0; i < b->facility_count; i++) {
-        for (int j = 0; j < MAX_FACILITIES; j++) {
-            if (strcmp(b->facilities[i], facility_names[j]) == 0) {
-                facility_availability[j]++;
-                // printf("Facility released: %s (Remaining: %d)\n", facility_names[j], facility_availability[j]); // DEBUG
-                break;
-            }
-        }
-    }
+// Schedule into the channel's mapping and hand the records to the printBookings child. The mapping's kept tells
+// the process owning the cache which records are new (see store_schedule).
+void schedule_by_day(SchedulerContext* ctx, ScheduleChannel* channel, SortOrder order, DayScheduler schedule_day, const ScheduleCache* cache) {
+    RecordWriter writer;
+    record_writer_init(&writer, channel);
+    int kept = schedule_days_into(ctx, &writer, order, schedule_day, cache, true);
+#ifndef DEBUG_TEXT_IPC
+    channel->shared->kept = kept;
+#else
+    (void)kept;
+#endif
+    record_writer_finish(&writer);
 }
 
-// Booking Functions
-void add_booking(const char* command, int id) {
-    if (booking_count >= MAX_BOOKINGS) {
-        printf("Maximum booking limit reached.\n");
-        return;
-    }
-
-    Booking* b = &bookings[booking_count];
-    char facilities[MAX_LINE] = {0};
+// Pass a decision on to the printBookings child; parking_slot -1 = rejected
+static void record_decision(SchedulerContext* ctx, RecordWriter* writer, int b, int parking_slot) {
+    Schedule s;
+    s.id = b;
+    s.parking_slot = parking_slot;
+    s.start_time = bookings.start_minute[b];
+    s.end_time = bookings.end_minute[b];
+    s.status = (parking_slot > 0) ? RECORD_SCHEDULED : RECORD_REJECTED;
+
+    emit_schedule(writer, &s);
+    ctx->summary[(parking_slot > 0) ? 1 : 2]++;
+}
 
-    // Parse the command
-    if (sscanf(command, "%s -%s %s %s %f %[^\n]",
-               b->type, b->client, b->date, b->time, &b->duration, facilities) < 5) {
-        printf("Error: Invalid booking format.\n");
-        return;
+// Accept or reject one booking. It needs a bay and its facilities for its whole time; the cheap bay lookup goes first
+static void decide_booking(SchedulerContext* ctx, SlotAllocator* slots, RecordWriter* writer, int b) {
+    ctx->summary[0]++;
+    int bay = slot_allocator_find(slots, bookings.start_minute[b], slot_policy);
+    if (bay >= 0 && check_and_reserve_facilities(ctx, b)) {
+        // Assign the booking to the slot
+        slot_allocator_assign(slots, bay, bookings.end_minute[b]);
+        record_decision(ctx, writer, b, bay + 1);
+    } else { // If no slot or not enough facilities are available, reject the booking
+        record_decision(ctx, writer, b, -1);
     }
+}
 
-    // Parse facilities
-    b->id = id;
-    b->facility_count = 0;
-    char* facility = strtok(facilities, " ");
-    while (facility && b->facility_count < MAX_FACILITIES) {
-        strncpy(b->facilities[b->facility_count], facility, MAX_FACILITY_NAME_LENGTH - 1);
-        b->facilities[b->facility_count][MAX_FACILITY_NAME_LENGTH - 1] = '\0';
-        b->facility_count++;
-        facility = strtok(NULL, " ");
-    }
-
-    booking_count++;
-}
-
-void fcfs_schedule_to_pipe(int pipe_fd) {
-    int parking_slots[TOTAL_PARKING_SLOTS] = {0};
-    char buffer[256];
-
-    for (int i = 0; i < booking_count; i++) {
-        summary[0][0]++; 
-        int assigned = 0;
-        int start_time = convert_time_to_int(bookings[i].time); 
-
-        // Check facility availability and reject if no avaliable according to the rules (3 facilities)
-        if (!check_and_reserve_facilities(&bookings[i])) {
-            schedule[schedule_count].id = bookings[i].id;
-            schedule[schedule_count].parking_slot = -1;
-            schedule[schedule_count].start_time = start_time;
-            schedule[schedule_count].end_time = start_time + bookings[i].duration;
-            strcpy(schedule[schedule_count].status, "Rejected");
-
-            snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                     schedule[schedule_count].id,
-                     bookings[i].client,
-                     bookings[i].type,
-                     bookings[i].date,
-                     bookings[i].time,
-                     bookings[i].duration,
-                     bookings[i].facility_count);
-            for (int k = 0; k < bookings[i].facility_count; k++) {
-                strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                strncat(buffer, bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-            }
-            snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                     schedule[schedule_count].parking_slot,
-                     schedule[schedule_count].status);
-            write(pipe_fd, buffer, strlen(buffer));
-            schedule_count++;
-            summary[0][2]++; 
-            continue;
-        }
+// FCFS and PRIO for one day: the entries already come in the algorithm's order (arrival, or priority then arrival)
+static void in_order_schedule_day(SchedulerContext* ctx, SlotAllocator* slots, RecordWriter* writer, const int* entries, int count) {
+    for (int i = 0; i < count; i++) {
+        decide_booking(ctx, slots, writer, entries[i]);
+    }
+}
 
-        for (int j = 0; j < TOTAL_PARKING_SLOTS; j++) {
-            if (parking_slots[j] <= start_time) {
-                // Assign the booking to the slot
-                schedule[schedule_count].id = bookings[i].id;
-                schedule[schedule_count].parking_slot = j + 1;
-                schedule[schedule_count].start_time = start_time;
-                schedule[schedule_count].end_time = start_time + bookings[i].duration;
-                strcpy(schedule[schedule_count].status, "Scheduled");
-                parking_slots[j] = schedule[schedule_count].end_time;
-
-                release_facilities(&bookings[i]);
-
-                snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                         schedule[schedule_count].id,
-                         bookings[i].client,
-                         bookings[i].type,
-                         bookings[i].date,
-                         bookings[i].time,
-                         bookings[i].duration,
-                         bookings[i].facility_count);
-                for (int k = 0; k < bookings[i].facility_count; k++) {
-                    strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                    strncat(buffer, bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-                }
-                snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                         schedule[schedule_count].parking_slot,
-                         schedule[schedule_count].status);
-                write(pipe_fd, buffer, strlen(buffer));
-                schedule_count++;
-                summary[0][1]++; 
-                assigned = 1;
-                break;
-            }
-        }
+void fcfs_schedule_to_pipe(SchedulerContext* ctx, ScheduleChannel* channel, const ScheduleCache* cache) {
+    BENCH_START(started);
+    schedule_by_day(ctx, channel, SORT_BY_ARRIVAL, in_order_schedule_day, cache);
+    BENCH_END("schedule", "fcfs", started);
+}
 
-        if (!assigned) { // If no slot is available, reject the booking
-            release_facilities(&bookings[i]); 
-            schedule[schedule_count].id = bookings[i].id;
-            schedule[schedule_count].parking_slot = -1;
-            schedule[schedule_count].start_time = start_time;
-            schedule[schedule_count].end_time = start_time + bookings[i].duration;
-            strcpy(schedule[schedule_count].status, "Rejected");
-
-            snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                     schedule[schedule_count].id,
-                     bookings[i].client,
-                     bookings[i].type,
-                     bookings[i].date,
-                     bookings[i].time,
-                     bookings[i].duration,
-                     bookings[i].facility_count);
-            for (int k = 0; k < bookings[i].facility_count; k++) {
-                strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                strncat(buffer, bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-            }
-            snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                     schedule[schedule_count].parking_slot,
-                     schedule[schedule_count].status);
-            write(pipe_fd, buffer, strlen(buffer));
-            schedule_count++;
-            summary[0][2]++;
-        }
+// Bring the FCFS cache, and with it the occupancy index, up to every booking added so far, in this process: the
+// days the new bookings touch are scheduled again one after another, with no fork and no report
+void update_fcfs_schedule() {
+#ifndef DEBUG_TEXT_IPC
+    ScheduleCache* cache = &schedule_caches[ALGORITHM_FCFS];
+    if (cache->booking_count == booking_count) return;
+
+    SchedulerContext* ctx = acquire_scheduler_context();
+    RecordWriter writer = {.fd = -1, .count = 0};
+    writer.records = malloc((size_t)booking_count * sizeof(ScheduleRecord));
+    if (writer.records == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
     }
+    int kept = schedule_days_into(ctx, &writer, SORT_BY_ARRIVAL, in_order_schedule_day, cache, false);
+    schedule_cache_store(cache, writer.records, kept, booking_count);
+    free(writer.records);
+    release_scheduler_context(ctx);
+#endif
 }
 
 // DEBUG: Short dummy data
@@ -390,321 +2920,114 @@ void fcfs_schedule_to_pipe(int pipe_fd) {
 //     add_booking("addParking -member_A 2025-05-10 12:00 2.0 battery cable", id++);
 // }
 
-void shortest_job_first_to_pipe(int pipe_fd) {
-    int parking_slots[TOTAL_PARKING_SLOTS] = {0};
-    char buffer[256];
-
-    // Create a local copy of the bookings array
-    Booking local_bookings[MAX_BOOKINGS];
-    memcpy(local_bookings, bookings, sizeof(bookings));
-
-    // Sort the local copy by start time and duration
-    for (int i = 0; i < booking_count - 1; i++) {
-        for (int j = i + 1; j < booking_count; j++) {
-            if (convert_time_to_int(local_bookings[i].time) > convert_time_to_int(local_bookings[j].time) ||
-                (convert_time_to_int(local_bookings[i].time) == convert_time_to_int(local_bookings[j].time) &&
-                 local_bookings[i].duration > local_bookings[j].duration)) {
-                Booking temp = local_bookings[i];
-                local_bookings[i] = local_bookings[j];
-                local_bookings[j] = temp;
-            }
-        }
+// SJF for one day, event driven: entries arrive in start time order. At each start time every booking that
+// arrives joins the ready queue and the shortest ready booking is decided first. Deciding takes no time, so
+// the queue is empty again before the clock moves on to the next start time.
+static void sjf_schedule_day(SchedulerContext* ctx, SlotAllocator* slots, RecordWriter* writer, const int* entries, int count) {
+    ReadyQueue ready;
+    ready.items = malloc((size_t)(count > 0 ? count : 1) * sizeof(int));
+    ready.count = 0;
+    if (ready.items == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
     }
 
-    // Schedule bookings using the sorted local copy
-    for (int i = 0; i < booking_count; i++) {
-        summary[2][0]++;
-        int assigned = 0;
-        int start_time = convert_time_to_int(local_bookings[i].time);
-        int end_time = start_time + local_bookings[i].duration;
-
-        // Check facility availability and reject if unavailable
-        if (!check_and_reserve_facilities(&local_bookings[i])) {
-            release_facilities(&local_bookings[i]);
-            schedule[schedule_count].id = local_bookings[i].id;
-            schedule[schedule_count].parking_slot = -1;
-            schedule[schedule_count].start_time = start_time;
-            schedule[schedule_count].end_time = end_time;
-            strcpy(schedule[schedule_count].status, "Rejected");
-
-            snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                     schedule[schedule_count].id,
-                     local_bookings[i].client,
-                     local_bookings[i].type,
-                     local_bookings[i].date,
-                     local_bookings[i].time,
-                     local_bookings[i].duration,
-                     local_bookings[i].facility_count);
-            for (int k = 0; k < local_bookings[i].facility_count; k++) {
-                strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                strncat(buffer, local_bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-            }
-            snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                     schedule[schedule_count].parking_slot,
-                     schedule[schedule_count].status);
-            write(pipe_fd, buffer, strlen(buffer));
-
-            schedule_count++;
-            summary[2][2]++;
-            continue;
-        }
-
-        // Check parking slot availability
-        for (int j = 0; j < TOTAL_PARKING_SLOTS; j++) {
-            if (parking_slots[j] <= start_time) {
-                // Assign the booking to the slot
-                schedule[schedule_count].id = local_bookings[i].id;
-                schedule[schedule_count].parking_slot = j + 1;
-                schedule[schedule_count].start_time = start_time;
-                schedule[schedule_count].end_time = end_time;
-                strcpy(schedule[schedule_count].status, "Scheduled");
-                parking_slots[j] = end_time;
-
-                release_facilities(&local_bookings[i]);
-
-                snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                         schedule[schedule_count].id,
-                         local_bookings[i].client,
-                         local_bookings[i].type,
-                         local_bookings[i].date,
-                         local_bookings[i].time,
-                         local_bookings[i].duration,
-                         local_bookings[i].facility_count);
-                for (int k = 0; k < local_bookings[i].facility_count; k++) {
-                    strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                    strncat(buffer, local_bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-                }
-                snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                         schedule[schedule_count].parking_slot,
-                         schedule[schedule_count].status);
-                write(pipe_fd, buffer, strlen(buffer));
-
-                schedule_count++;
-                summary[2][1]++;
-                assigned = 1;
-                break;
-            }
+    int next = 0;
+    while (next < count) {
+        int now = bookings.start_minute[entries[next]];
+        while (next < count && bookings.start_minute[entries[next]] == now) {
+            ready_queue_push(&ready, entries[next++]);
         }
 
-        // If no slot is available, reject the booking
-        if (!assigned) {
-            release_facilities(&local_bookings[i]);
-            schedule[schedule_count].id = local_bookings[i].id;
-            schedule[schedule_count].parking_slot = -1;
-            schedule[schedule_count].start_time = start_time;
-            schedule[schedule_count].end_time = end_time;
-            strcpy(schedule[schedule_count].status, "Rejected");
-
-            snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                     schedule[schedule_count].id,
-                     local_bookings[i].client,
-                     local_bookings[i].type,
-                     local_bookings[i].date,
-                     local_bookings[i].time,
-                     local_bookings[i].duration,
-                     local_bookings[i].facility_count);
-            for (int k = 0; k < local_bookings[i].facility_count; k++) {
-                strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                strncat(buffer, local_bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-            }
-            snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                     schedule[schedule_count].parking_slot,
-                     schedule[schedule_count].status);
-            write(pipe_fd, buffer, strlen(buffer));
-
-            schedule_count++;
-            summary[2][2]++;
+        while (ready.count > 0) {
+            decide_booking(ctx, slots, writer, ready_queue_pop(&ready));
         }
     }
+    free(ready.items);
 }
 
-void priority_schedule_to_pipe(int pipe_fd) {
-    int parking_slots[TOTAL_PARKING_SLOTS] = {0}; 
-    char buffer[256];
-
-    // Sort bookings by priority (lower priority value = higher priority)
-    for (int i = 0; i < booking_count - 1; i++) {
-        for (int j = i + 1; j < booking_count; j++) {
-            if (get_priority(bookings[i].type) > get_priority(bookings[j].type)) {
-                Booking temp = bookings[i];
-                bookings[i] = bookings[j];
-                bookings[j] = temp;
-            }
-        }
-    }
-
-    for (int i = 0; i < booking_count; i++) {
-        summary[1][0]++;
-        int assigned = 0;
-        int start_time = convert_time_to_int(bookings[i].time);
-        int end_time = start_time + bookings[i].duration;
-
-        // Check facility availability and reject if unavailable
-        if (!check_and_reserve_facilities(&bookings[i])) {
-            release_facilities(&bookings[i]);
-            schedule[schedule_count].id = bookings[i].id;
-            schedule[schedule_count].parking_slot = -1;
-            schedule[schedule_count].start_time = start_time;
-            schedule[schedule_count].end_time = end_time;
-            strcpy(schedule[schedule_count].status, "Rejected");
-
-            snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                     schedule[schedule_count].id,
-                     bookings[i].client,
-                     bookings[i].type,
-                     bookings[i].date,
-                     bookings[i].time,
-                     bookings[i].duration,
-                     bookings[i].facility_count);
-            for (int k = 0; k < bookings[i].facility_count; k++) {
-                strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                strncat(buffer, bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-            }
-            snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                     schedule[schedule_count].parking_slot,
-                     schedule[schedule_count].status);
-            write(pipe_fd, buffer, strlen(buffer));
-
-            schedule_count++;
-            summary[1][2]++; 
-            continue;
-        }
-
-        // Check parking slot availability
-        for (int j = 0; j < TOTAL_PARKING_SLOTS; j++) {
-            if (parking_slots[j] <= start_time) {
-                // Assign the booking to the slot
-                schedule[schedule_count].id = bookings[i].id;
-                schedule[schedule_count].parking_slot = j + 1;
-                schedule[schedule_count].start_time = start_time;
-                schedule[schedule_count].end_time = end_time;
-                strcpy(schedule[schedule_count].status, "Scheduled");
-                parking_slots[j] = end_time;
-
-                snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                         schedule[schedule_count].id,
-                         bookings[i].client,
-                         bookings[i].type,
-                         bookings[i].date,
-                         bookings[i].time,
-                         bookings[i].duration,
-                         bookings[i].facility_count);
-                for (int k = 0; k < bookings[i].facility_count; k++) {
-                    strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                    strncat(buffer, bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-                }
-                snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                         schedule[schedule_count].parking_slot,
-                         schedule[schedule_count].status);
-                write(pipe_fd, buffer, strlen(buffer));
-
-                schedule_count++;
-                summary[1][1]++; 
-                assigned = 1;
-                break;
-            }
-        }
-
-        // If no slot is available, reject the booking
-        if (!assigned) {
-            release_facilities(&bookings[i]); 
-            schedule[schedule_count].id = bookings[i].id;
-            schedule[schedule_count].parking_slot = -1;
-            schedule[schedule_count].start_time = start_time;
-            schedule[schedule_count].end_time = end_time;
-            strcpy(schedule[schedule_count].status, "Rejected");
-
-            snprintf(buffer, sizeof(buffer), "%d %s %s %s %s %.2f %d",
-                     schedule[schedule_count].id,
-                     bookings[i].client,
-                     bookings[i].type,
-                     bookings[i].date,
-                     bookings[i].time,
-                     bookings[i].duration,
-                     bookings[i].facility_count);
-            for (int k = 0; k < bookings[i].facility_count; k++) {
-                strncat(buffer, " ", sizeof(buffer) - strlen(buffer) - 1);
-                strncat(buffer, bookings[i].facilities[k], sizeof(buffer) - strlen(buffer) - 1);
-            }
-            snprintf(buffer + strlen(buffer), sizeof(buffer) - strlen(buffer), " %d %s\n",
-                     schedule[schedule_count].parking_slot,
-                     schedule[schedule_count].status);
-            write(pipe_fd, buffer, strlen(buffer));
+void shortest_job_first_to_pipe(SchedulerContext* ctx, ScheduleChannel* channel, const ScheduleCache* cache) {
+    // Bookings arrive by start time; the ready queue picks the shortest (ties keep FCFS order)
+    BENCH_START(started);
+    schedule_by_day(ctx, channel, SORT_BY_START_TIME, sjf_schedule_day, cache);
+    BENCH_END("schedule", "sjf", started);
+}
 
-            schedule_count++;
-            summary[1][2]++; 
-        }
-    }
+void priority_schedule_to_pipe(SchedulerContext* ctx, ScheduleChannel* channel, const ScheduleCache* cache) {
+    // Order bookings by priority (lower priority value = higher priority), ties keep FCFS order
+    BENCH_START(started);
+    schedule_by_day(ctx, channel, SORT_BY_PRIORITY, in_order_schedule_day, cache);
+    BENCH_END("schedule", "prio", started);
 }
 /*
 sample line is like this: 3 member_D addEssentials 2025-05-10 09:00 2.00 1 battery 1 Scheduled
-parse each word by using strtok with "\n"
+parse each word by using strtok with "\n", false if the line is cut short
 */
-void parse_and_classify_line(const char* line) {
+bool parse_schedule_line(const char* line, ScheduleRecord* record) {
     Schedule s;
     Booking b;
+    char status[MAX_NAME_LEN];
     char temp[256];
     strncpy(temp, line, sizeof(temp) - 1);
     temp[sizeof(temp) - 1] = '\0';
 
     // printf("%s\n", line);
     char *token = strtok(temp, " ");
-    if (!token) return;
+    if (!token) return false;
     s.id = atoi(token);
-    b.id = s.id;
 
     token = strtok(NULL, " ");
-    if (!token) return;
-    strncpy(b.client, token, MAX_NAME_LEN);
+    if (!token) return false;
+    strncpy(b.text.client, token, MAX_NAME_LEN);
 
     token = strtok(NULL, " ");
-    if (!token) return;
-    strncpy(b.type, token, MAX_NAME_LEN);
+    if (!token) return false;
+    strncpy(b.text.type, token, MAX_NAME_LEN);
 
     token = strtok(NULL, " ");
-    if (!token) return;
-    strncpy(b.date, token, MAX_DATE_LEN);
+    if (!token) return false;
+    strncpy(b.text.date, token, MAX_DATE_LEN);
 
     token = strtok(NULL, " ");
-    if (!token) return;
-    strncpy(b.time, token, MAX_DATE_LEN);
+    if (!token) return false;
+    strncpy(b.text.time, token, MAX_DATE_LEN);
 
     token = strtok(NULL, " ");
-    if (!token) return;
+    if (!token) return false;
     b.duration = atof(token);
 
     token = strtok(NULL, " ");
-    if (!token) return;
-    b.facility_count = atoi(token);
+    if (!token) return false;
+    b.facilities.count = (unsigned char)atoi(token);
     
-    for (int i = 0; i < b.facility_count; i++) {
+    b.facility_mask = 0;
+    for (int i = 0; i < b.facilities.count; i++) {
         token = strtok(NULL, " ");
-        if (!token) return;
-        strncpy(b.facilities[i], token, MAX_FACILITY_NAME_LENGTH - 1);
-        b.facilities[i][MAX_FACILITY_NAME_LENGTH - 1] = '\0';
+        if (!token) return false;
+        int id = facility_id(token);
+        if (id < 0) return false;
+        b.facilities.ids[i] = (unsigned char)id;
+        b.facility_mask |= 1u << id;
     }
     
     token = strtok(NULL, " ");
-    if (!token) return;
+    if (!token) return false;
     s.parking_slot = atoi(token);
 
     token = strtok(NULL, " ");
-    if (!token) return;
-    strncpy(s.status, token, MAX_NAME_LEN);
+    if (!token) return false;
+    strncpy(status, token, MAX_NAME_LEN);
     
-    s.start_time = convert_time_to_int(b.time);
-    s.end_time = s.start_time + b.duration;
+    s.start_time = bookings.start_minute[s.id];
+    s.end_time = bookings.end_minute[s.id];
     
-    int member_idx = get_index_from_member(b.client);
-    if (member_idx == -1) return;
-
-    refer_booking[s.id] = b;
-
-    if (strcmp(s.status, "Scheduled") == 0) {
-        accepted[member_idx][accepted_count[member_idx]++] = s;
-    } else {
-        rejected[member_idx][rejected_count[member_idx]++] = s;
-    }
+    record->id = s.id;
+    record->parking_slot = s.parking_slot;
+    record->start_time = s.start_time;
+    record->end_time = s.end_time;
+    record->facility_mask = b.facility_mask;
+    record->status = (strcmp(status, record_status_names[RECORD_SCHEDULED]) == 0) ? RECORD_SCHEDULED : RECORD_REJECTED;
+    return true;
 
     // DEBUG: is the data correct?
     // printf("ID: %d\n", b.id);
@@ -717,94 +3040,257 @@ void parse_and_classify_line(const char* line) {
     // printf("Facilities (%d): ", b.facility_count);
 
     // for (int i = 0; i < b.facility_count; i++) {
-    //     printf("%s ", b.facilities[i]);
+    //     printf("%s ", site.facility_names[b.facility_ids[i]]);
     // }
     // printf("\n");
 }
 
 
+// Group the decisions by member, accepted and rejected apart, keeping their order within each member.
+// A counting sort: count per member, turn the counts into offsets, then drop every decision into place.
+void classify_records(SchedulerContext* ctx, const ScheduleRecord* records, int count) {
+    int member_count = members.count;
+    int capacity = ctx->offsets_capacity;
+    ctx->accepted_offsets = grow_array(ctx->accepted_offsets, &capacity, member_count + 1, sizeof(int));
+    ctx->rejected_offsets = grow_array(ctx->rejected_offsets, &ctx->offsets_capacity, member_count + 1, sizeof(int));
+    int* accepted = ctx->accepted_offsets;
+    int* rejected = ctx->rejected_offsets;
+    memset(accepted, 0, (size_t)(member_count + 1) * sizeof(int));
+    memset(rejected, 0, (size_t)(member_count + 1) * sizeof(int));
+
+    for (int i = 0; i < count; i++) {
+        int m = bookings.member[records[i].id];
+        if (records[i].status == RECORD_SCHEDULED) {
+            accepted[m + 1]++;
+        } else {
+            rejected[m + 1]++;
+        }
+    }
+    for (int m = 0; m < member_count; m++) {
+        accepted[m + 1] += accepted[m];
+        rejected[m + 1] += rejected[m];
+    }
+    ctx->accepted = grow_array(ctx->accepted, &ctx->accepted_capacity, accepted[member_count], sizeof(Schedule));
+    ctx->rejected = grow_array(ctx->rejected, &ctx->rejected_capacity, rejected[member_count], sizeof(Schedule));
+
+    // Next free place of every member, in both lists
+    int* next = malloc((size_t)(2 * member_count + 1) * sizeof(int));
+    if (next == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(next, accepted, (size_t)member_count * sizeof(int));
+    memcpy(next + member_count, rejected, (size_t)member_count * sizeof(int));
+
+    for (int i = 0; i < count; i++) {
+        const ScheduleRecord* record = &records[i];
+        int m = bookings.member[record->id];
+        Schedule* s = (record->status == RECORD_SCHEDULED) ? &ctx->accepted[next[m]++]
+                                                           : &ctx->rejected[next[member_count + m]++];
+        s->id = record->id;
+        s->parking_slot = record->parking_slot;
+        s->start_time = record->start_time;
+        s->end_time = record->end_time;
+        s->status = (RecordStatus)record->status;
+    }
+    free(next);
+}
+
+// Report Functions
+void report_writer_init(ReportWriter* report, int fd) {
+    fflush(stdout); // Anything printf'd before must come out first
+    report->fd = fd;
+    report->used = 0;
+    report->buffer = malloc(REPORT_BUFFER_SIZE);
+    if (report->buffer == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void report_writer_flush(ReportWriter* report) {
+    write_fully(report->fd, report->buffer, report->used);
+    report->used = 0;
+}
+
+void report_writer_free(ReportWriter* report) {
+    report_writer_flush(report);
+    free(report->buffer);
+}
+
+// Make room for size more bytes (size never exceeds a row)
+static inline void report_reserve(ReportWriter* report, size_t size) {
+    if (report->used + size > REPORT_BUFFER_SIZE) {
+        report_writer_flush(report);
+    }
+}
+
+static inline void report_put(ReportWriter* report, const char* text, size_t length) {
+    report_reserve(report, length);
+    memcpy(report->buffer + report->used, text, length);
+    report->used += length;
+}
+
+// Same as printf("%-*s", width, text)
+static inline void report_put_padded(ReportWriter* report, const char* text, int width) {
+    size_t length = strlen(text);
+    report_put(report, text, length);
+    if ((int)length < width) {
+        report_reserve(report, (size_t)width - length);
+        memset(report->buffer + report->used, ' ', (size_t)width - length);
+        report->used += (size_t)width - length;
+    }
+}
+
+// Same as printf("%-8s", "hh:mm") for minutes since midnight (overnight bookings go past 24:00)
+static void report_put_clock(ReportWriter* report, int minutes) {
+    int hours = minutes / 60;
+    if (hours >= 100) { // Longer than any booking can be, keep printf's behaviour anyway
+        char text[16];
+        snprintf(text, sizeof(text), "%02d:%02d", hours, minutes % 60);
+        report_put_padded(report, text, 8);
+        return;
+    }
+    char text[8] = {(char)('0' + hours / 10), (char)('0' + hours % 10), ':',
+                    (char)('0' + minutes % 60 / 10), (char)('0' + minutes % 10), ' ', ' ', ' '};
+    report_put(report, text, sizeof(text));
+}
+
+// Headers and other rare lines
+void report_printf(ReportWriter* report, const char* format, ...) {
+    char line[MAX_LINE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length >= (int)sizeof(line)) length = (int)sizeof(line) - 1;
+    report_put(report, line, (size_t)length);
+}
+
+// Member name as the report shows it: "member_A" becomes "Member_A"
+static const char* member_display_name(char* out, int member) {
+    strcpy(out, members.names[member]);
+    out[0] = (char)toupper((unsigned char)out[0]);
+    return out;
+}
+
+// One booking: date, times relative to the booking date, type, then one facility per line ("*" for none)
+void report_booking_row(ReportWriter* report, const Schedule* s) {
+    const BookingText* text = &bookings.text[s->id];
+    const FacilityList* facilities = &bookings.facilities[s->id];
+    int day_start = s->start_time - s->start_time % MINUTES_PER_DAY;
+    report_put_padded(report, text->date, 12);
+    report_put_clock(report, s->start_time - day_start);
+    report_put_clock(report, s->end_time - day_start);
+    report_put_padded(report, text->type, 16);
+
+    if (facilities->count == 0) {
+        report_put(report, "*\n", 2);
+        return;
+    }
+    for (int k = 0; k < facilities->count; k++) {
+        if (k > 0) {
+            report_put_padded(report, "", 44);
+        }
+        report_put_padded(report, site.facility_names[facilities->ids[k]], 0);
+        report_put(report, "\n", 1);
+    }
+}
+
 //add_booking("addParking -member_A 2025-05-10 08:00 3.0 battery cable;");
-void printBookings(const char* algorithm, int pipe_fd) {
+void printBookings(SchedulerContext* ctx, const char* algorithm, ScheduleChannel* channel) {
+    // ipc: receiving and sorting out the decisions (the text build also waits for the scheduler while it streams)
+#ifdef DEBUG_TEXT_IPC
+    BENCH_START(ipc_started);
     char buffer[4096];
-    char temp[4096] = "";
-    int bytes_read;
+    char temp[sizeof(buffer) + IPC_LINE_SIZE + 1]; // Room for a partial line carried over between reads
+    size_t pending = 0;
+    ssize_t bytes_read;
+    ScheduleRecord* records = NULL;
+    int count = 0, capacity = 0;
 
     // Read lines from parent
-    while ((bytes_read = read(pipe_fd, buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[bytes_read] = '\0';
-        strcat(temp, buffer);
+    while ((bytes_read = read(channel->pipe_fd[0], buffer, sizeof(buffer))) > 0) {
+        if (pending + (size_t)bytes_read >= sizeof(temp)) {
+            pending = 0; // Longer than any record line, so it cannot be one: drop it
+        }
+        memcpy(temp + pending, buffer, (size_t)bytes_read);
+        pending += (size_t)bytes_read;
+        temp[pending] = '\0';
 
+        char* line = temp;
         char* newline;
-
-        while ((newline = strchr(temp, '\n')) != NULL) {
+        while ((newline = strchr(line, '\n')) != NULL) {
             *newline = '\0';
-            parse_and_classify_line(temp);
-
-            memmove(temp, newline + 1, strlen(newline + 1) + 1);
+            STAT_START(parse_started);
+            records = grow_array(records, &capacity, count + 1, sizeof(ScheduleRecord));
+            if (parse_schedule_line(line, &records[count])) {
+                count++;
+            }
+            STAT_END(STAT_CHILD_PARSE, parse_started);
+            line = newline + 1;
         }
+        pending -= (size_t)(line - temp);
+        memmove(temp, line, pending);
+    }
+    classify_records(ctx, records, count);
+    free(records);
+#else
+    // Wait for the completion notice, then read the records straight from the shared mapping
+    int count = 0;
+    if (!read_fully(channel->pipe_fd[0], &count, sizeof(count))) {
+        count = 0;
     }
+    BENCH_START(ipc_started);
+    STAT_START(classify_started);
+    classify_records(ctx, channel->shared->records, count);
+    stat_record(STAT_CHILD_PARSE, count, classify_started);
+#endif
+    BENCH_END("ipc", algorithm, ipc_started);
+    BENCH_START(report_started);
 
-    // Accepted Bookings
-    printf("\n*** Parking Booking - ACCEPTED / %s ***\n\n", algorithm);
-    for (int i = 0; i < NUM_OF_MEMBER; i++) {
-        printf("Member_%c has the following bookings:\n\n", 'A' + i);
+    ReportWriter report;
+    report_writer_init(&report, STDOUT_FILENO);
 
-        if (accepted_count[i] == 0) {
-            printf("No accepted bookings.\n\n");
+    // Accepted Bookings
+    report_printf(&report, "\n*** Parking Booking - ACCEPTED / %s ***\n\n", algorithm);
+    char name[MAX_NAME_LEN];
+    for (int i = 0; i < members.count; i++) {
+        int first = ctx->accepted_offsets[i], last = ctx->accepted_offsets[i + 1];
+        report_printf(&report, "%s has the following bookings:\n\n", member_display_name(name, i));
+
+        if (first == last) {
+            report_printf(&report, "No accepted bookings.\n\n");
             continue;
         }
-        
-        printf("%-12s%-8s%-8s%-16s%-10s\n", "Date", "Start", "End", "Type", "Device");
-        printf("==========================================================\n");
-        for (int j = 0; j < accepted_count[i]; j++) {
-            Schedule s = accepted[i][j];
-            Booking b = refer_booking[s.id];
-
-            printf("%-12s%-8d%-8d%-16s", b.date, s.start_time, s.end_time, b.type);
-            
-            if (b.facility_count > 0) {
-                printf("%s\n", b.facilities[0]);
-                for (int k = 1; k < b.facility_count; k++) {
-                    printf("%44s%s\n", "", b.facilities[k]);
-                }
-            }
-            else {
-                printf("%s\n", "*"); // IF NO FACILTY
-            }
-            
+
+        report_printf(&report, "%-12s%-8s%-8s%-16s%-10s\n", "Date", "Start", "End", "Type", "Device");
+        report_printf(&report, "==========================================================\n");
+        for (int j = first; j < last; j++) {
+            report_booking_row(&report, &ctx->accepted[j]);
         }
-        printf("\n");
+        report_put(&report, "\n", 1);
     }
 
     // Print Rejected bookings
-    printf("\n*** Parking Booking - REJECTED / %s ***\n\n", algorithm);
-    for (int i = 0; i < NUM_OF_MEMBER; i++) {
-        if (rejected_count[i] == 0) continue;
-
-        printf("Member_%c (%d bookings rejected):\n\n", 'A' + i, rejected_count[i]);
-        printf("%-12s%-8s%-8s%-16s%-8s\n", "Date", "Start", "End", "Type", "Essentials");
-        printf("==========================================================\n");
-
-        for (int j = 0; j < rejected_count[i]; j++) {
-            Schedule s = rejected[i][j];
-            Booking b = refer_booking[s.id];
+    report_printf(&report, "\n*** Parking Booking - REJECTED / %s ***\n\n", algorithm);
+    for (int i = 0; i < members.count; i++) {
+        int first = ctx->rejected_offsets[i], last = ctx->rejected_offsets[i + 1];
+        if (first == last) continue;
 
-            printf("%-12s%-8d%-8d%-16s", b.date, s.start_time, s.end_time, b.type);
+        report_printf(&report, "%s (%d bookings rejected):\n\n", member_display_name(name, i), last - first);
+        report_printf(&report, "%-12s%-8s%-8s%-16s%-8s\n", "Date", "Start", "End", "Type", "Essentials");
+        report_printf(&report, "==========================================================\n");
 
-            if (b.facility_count > 0) {
-                printf("%s\n", b.facilities[0]);
-                for (int k = 1; k < b.facility_count; k++) {
-                    printf("%44s%s\n", "", b.facilities[k]);
-                }
-            }
-            else {
-                printf("%s\n", "*"); // IF NO FACILITY
-            }
+        for (int j = first; j < last; j++) {
+            report_booking_row(&report, &ctx->rejected[j]);
         }
-        printf("\n");
+        report_put(&report, "\n", 1);
     }
-    printf("- End -\n");
-    printf("==========================================================\n");
+    report_printf(&report, "- End -\n");
+    report_printf(&report, "==========================================================\n");
+    report_writer_free(&report);
+    BENCH_END("report", algorithm, report_started);
 }
 
 // DEBUG: run dummy data thing 
@@ -861,196 +3347,613 @@ void printBookings(const char* algorithm, int pipe_fd) {
 //     }
 // }
 
-void trim_whitespace(char* str) {
-    char* end;
+// printBookings -all: the three schedulers run at the same time as forked workers, each with its own copy
+// of the scheduling state, then the reports are printed one after another in FCFS, PRIO, SJF order
+void run_all_algorithms() {
+    const char* algorithms[] = {"fcfs", "prio", "sjf"};
+    void (*functions[])(SchedulerContext*, ScheduleChannel*, const ScheduleCache*) = {fcfs_schedule_to_pipe, priority_schedule_to_pipe, shortest_job_first_to_pipe};
+    ScheduleChannel channels[NUM_ALGORITHMS];
+    pid_t workers[NUM_ALGORITHMS];
+    int summary[NUM_ALGORITHMS][4] = {{0}}; // [algorithm][metric]
+
+    fflush(stdout);
+
+    // Start every scheduler before printing anything
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        open_schedule_channel(&channels[i], booking_count);
+        stats_flush();
+        workers[i] = fork();
+        if (workers[i] == -1) {
+            perror("fork error");
+            exit(EXIT_FAILURE);
+        }
+        if (workers[i] == 0) {
+            SchedulerContext* ctx = acquire_scheduler_context();
+            close(channels[i].pipe_fd[0]);
+            functions[i](ctx, &channels[i], &schedule_caches[i]);
+            memcpy(channels[i].shared->summary, ctx->summary, sizeof(ctx->summary));
+            close(channels[i].pipe_fd[1]);
+            stats_flush();
+            exit(0);
+        }
+        close(channels[i].pipe_fd[1]);
+    }
+
+    // Print the reports in a fixed order, each reporter waits for its own scheduler's completion notice
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        stats_flush();
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork error");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            printBookings(acquire_scheduler_context(), algorithms[i], &channels[i]);
+            close(channels[i].pipe_fd[0]);
+            stats_flush();
+            exit(0);
+        }
+        waitpid(pid, NULL, 0);
+    }
 
-    end = str + strlen(str) - 1;
-    while (end > str && (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r')) {
-        *end = '\0';
-        end--;
+    // Collect each worker's summary row for the performance report
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        waitpid(workers[i], NULL, 0);
+        memcpy(summary[i], channels[i].shared->summary, sizeof(summary[i]));
+        // The worker only read its copy of the cache, keep its schedule here for the next printBookings
+        store_schedule(&schedule_caches[i], &channels[i]);
+        close(channels[i].pipe_fd[0]);
+        close_schedule_channel(&channels[i]);
     }
+    generate_performance_report(summary);
 }
 
-void processInput(FILE* input, bool isBatchFile) {
-    char line[MAX_COMMAND_LENGTH];
-    int lineCount = 0;
+// Run one trimmed, non-empty command line. Returns false when the program should end.
+bool process_command(char* line, int length, bool isBatchFile) {
+    // // Debug: is line correct??
+    // printf("Trimmed line: '%s'\n", line);
 
-    while (1) {
-        if (!isBatchFile) {
-            printf("Please enter booking:\n");
+    // Semicolon Logic
+    if (line[length - 1] != ';') {
+        printf("Error: Command must end with a semicolon (;).\n");
+        return true;
+    }
+    line[--length] = '\0';
+
+    // Process other command logic
+    if (!isBatchFile && strcmp(line, "endProgram") == 0) {
+        printf("->Bye!\n");
+        return false;
+    }
+
+    if (!isBatchFile && strncmp(line, "addBatch", 8) == 0) {
+        if (!validateAddBatchCommand(line)) {
+            printf("Error: Invalid addBatch command format. It should be in the format: addBatch -filename.dat;\n");
+            return true;
         }
 
-        // Input processing, read until white line, trim the whitespace, and skip emtpy lines
-        if (fgets(line, sizeof(line), input) == NULL) {
-            break; 
+        char* filename = strchr(line, '-');
+        if (filename) {
+            filename++;
+            int batchFile = open(filename, O_RDONLY);
+            if (batchFile == -1) {
+                printf("Error: Cannot open batch file: %s\n", filename);
+                return true;
+            }
+            posix_fadvise(batchFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+            printf("\nProcessing batch file: %s\n", filename);
+            BENCH_START(parse_started);
+            if (!process_batch_in_parallel(batchFile)) {
+                processInput(batchFile, true);
+            }
+            BENCH_END("parse", "none", parse_started);
+            close(batchFile);
+            printf("\nBatch processing completed.\n");
+        }
+    } else if (strncmp(line, "printBookings", 13) == 0) {
+        // Handle printBookings command
+        char cmd[MAX_NAME_LEN];
+        char algorithm[10];
+
+        if (sscanf(line, "%s -%s", cmd, algorithm) != 2) {
+            printf("Error: Invalid printBookings command format.\nUsage: printBookings -[algorithm(fcfs,sjf,prio,all)]\n");
+            return true;
         }
 
-        trim_whitespace(line);
+        if (!validatePrintBooking(algorithm)) {
+            printf("Error: Invalid algorithm '%s'. Must be 'fcfs', 'sjf', 'prio', or 'all'.\n", algorithm);
+            return true;
+        }
 
-        if (strlen(line) == 0) {
-            continue;
+        // Logic for running all algorithms
+        if (strcmp(algorithm, "all") == 0) {
+            run_all_algorithms();
+            return true;
         }
 
-        // // Debug: is line correct??
-        // printf("Trimmed line: '%s'\n", line);
+        SchedulerContext* ctx = acquire_scheduler_context();
+        ScheduleChannel channel;
+        pid_t pid;
+        open_schedule_channel(&channel, booking_count);
+        fflush(stdout); // The child must not inherit (and print again) unflushed output
+        stats_flush();
+        pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
 
-        // Semicolon Logic
-        if (line[strlen(line) - 1] != ';') {
-            printf("Error: Command must end with a semicolon (;).\n");
-            continue;
+        if (pid == 0) {
+            // Child process (print the booking)
+            close(channel.pipe_fd[1]);
+            printBookings(ctx, algorithm, &channel);
+            close(channel.pipe_fd[0]);
+            stats_flush();
+            exit(0);
+        } else {
+            // Parent process (run the scheduling algorithm)
+
+            // Logic for manual algorithms
+            if (strcmp(algorithm, "fcfs") == 0) {
+                close(channel.pipe_fd[0]);
+                fcfs_schedule_to_pipe(ctx, &channel, &schedule_caches[ALGORITHM_FCFS]);
+                close(channel.pipe_fd[1]);
+                store_schedule(&schedule_caches[ALGORITHM_FCFS], &channel);
+                wait(NULL);
+                close_schedule_channel(&channel);
+            } else if (strcmp(algorithm, "prio") == 0) {
+                close(channel.pipe_fd[0]);
+                priority_schedule_to_pipe(ctx, &channel, &schedule_caches[ALGORITHM_PRIO]);
+                close(channel.pipe_fd[1]);
+                store_schedule(&schedule_caches[ALGORITHM_PRIO], &channel);
+                wait(NULL);
+                close_schedule_channel(&channel);
+            } else if (strcmp(algorithm, "sjf") == 0) {
+                close(channel.pipe_fd[0]);
+                shortest_job_first_to_pipe(ctx, &channel, &schedule_caches[ALGORITHM_SJF]);
+                close(channel.pipe_fd[1]);
+                store_schedule(&schedule_caches[ALGORITHM_SJF], &channel);
+                wait(NULL);
+                close_schedule_channel(&channel);
+            }
+            release_scheduler_context(ctx);
+        }
+    } else if (strncmp(line, "saveSnapshot", 12) == 0 || strncmp(line, "loadSnapshot", 12) == 0) {
+        // saveSnapshot -bookings.snap; writes the booking table, loadSnapshot -bookings.snap; replaces it
+        char* path = line + 12;
+        while (*path == ' ') path++;
+        if (*path != '-' || path[1] == '\0') {
+            printf("Error: Invalid %.12s command format.\nUsage: %.12s -filename;\n", line, line);
+        } else if (line[0] == 's') {
+            save_snapshot(path + 1);
+        } else if (load_snapshot(path + 1) && wal.fd != -1) {
+            wal_checkpoint();
+        }
+    } else if (strncmp(line, "queryAvailability", 17) == 0) {
+        // queryAvailability -2025-05-16 14:00 3.0 battery; answers from the latest FCFS schedule
+        query_availability(line + 17);
+    } else if (strncmp(line, "printStats", 10) == 0) {
+        // printStats; or printStats -stats.json; to also dump the numbers as JSON
+        char* path = line + 10;
+        while (*path == ' ') path++;
+        if (*path == '\0') {
+            print_stats(NULL);
+        } else if (*path == '-' && path[1] != '\0') {
+            print_stats(path + 1);
+        } else {
+            printf("Error: Invalid printStats command format.\nUsage: printStats; or printStats -filename.json;\n");
+        }
+    } else {
+        // Validation logic
+        CommandType cmdType = parseCommandType(line);
+        if (cmdType == CMD_INVALID) {
+            printf("Error: Invalid command type\n");
+            return true;
         }
-        line[strlen(line) - 1] = '\0';
 
-        // Process other command logic
-        if (!isBatchFile && strcmp(line, "endProgram") == 0) {
-            printf("->Bye!\n");
-            break;
+        if (!validateCommandFormat(line, cmdType)) {
+            printf("Error: Invalid command format\n");
+            return true;
         }
+        processBooking(line);
+    }
+    return true;
+}
 
-        if (!isBatchFile && strncmp(line, "addBatch", 8) == 0) {
-            if (!validateAddBatchCommand(line)) {
-                printf("Error: Invalid addBatch command format. It should be in the format: addBatch -filename.dat;\n");
-                continue;
-            }
+// Strip trailing whitespace in place, returns the new length
+int trim_line(char* line, int length) {
+    while (length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t' || line[length - 1] == '\r')) {
+        length--;
+    }
+    line[length] = '\0';
+    return length;
+}
 
-            char* filename = strchr(line, '-');
-            if (filename) {
-                filename++;
-                FILE* batchFile = fopen(filename, "r");
-                if (!batchFile) {
-                    printf("Error: Cannot open batch file: %s\n", filename);
-                    continue;
-                }
-                printf("\nProcessing batch file: %s\n", filename);
-                processInput(batchFile, true);
-                fclose(batchFile);
-                printf("\nBatch processing completed.\n");
-            }
-        } else if (strncmp(line, "printBookings", 13) == 0) {
-            // Handle printBookings command
-            char cmd[MAX_NAME_LEN];
-            char algorithm[10];
-
-            if (sscanf(line, "%s -%s", cmd, algorithm) != 2) {
-                printf("Error: Invalid printBookings command format.\nUsage: printBookings -[algorithm(fcfs,sjf,prio,all)]\n");
-                continue;
-            }
+// Worker side: classify one batch line, parsing it into *b when it is a plain booking
+static BatchLineKind classify_batch_line(char* line, int length, Booking* b) {
+    length = trim_line(line, length);
+    if (length == 0) return BATCH_LINE_BLANK;
+    if (line[length - 1] != ';') return BATCH_LINE_REPLAY;
+    line[--length] = '\0';
+
+    CommandType cmdType = parseCommandType(line);
+    if (cmdType == CMD_INVALID || !validateCommandFormat(line, cmdType)) return BATCH_LINE_REPLAY;
+    STAT_SAMPLE_START(STAT_PARSE, started);
+    ParseResult result = parse_booking(line, b, false);
+    STAT_SAMPLE_END(STAT_PARSE, started);
+    return (result == PARSE_OK) ? BATCH_LINE_BOOKING : BATCH_LINE_REPLAY;
+}
 
-            if (!validatePrintBooking(algorithm)) {
-                printf("Error: Invalid algorithm '%s'. Must be 'fcfs', 'sjf', 'prio', or 'all'.\n", algorithm);
-                continue;
-            }
+// Count the lines in [p, end), including a last line without a '\n'
+static int count_lines(const char* p, const char* end) {
+    int count = 0;
+    while (p < end) {
+        const char* newline = memchr(p, '\n', (size_t)(end - p));
+        count++;
+        if (newline == NULL) break;
+        p = newline + 1;
+    }
+    return count;
+}
 
-            int pipe_fd[2];
-            pid_t pid;
-            if (pipe(pipe_fd) == -1) {
-                perror("pipe error");
-                exit(EXIT_FAILURE);
-            }
-            pid = fork();
-            if (pid == -1) {
-                perror("fork");
+// End of the line that contains p (one past its '\n'), or end
+static char* line_boundary(char* p, char* end) {
+    if (p >= end) return end;
+    char* newline = memchr(p, '\n', (size_t)(end - p));
+    return newline ? newline + 1 : end;
+}
+
+// Parse a big batch file on forked workers. Each window of the file is cut into one chunk per worker at line
+// boundaries; workers parse their chunk into a shared array of BatchLine, then the main process walks the
+// window in file order, appending parsed bookings (so ids match sequential parsing, new members are interned
+// here) and running every other line (errors, printBookings, new facility names) itself. Returns false if the file should be read normally.
+bool process_batch_in_parallel(int batch_fd) {
+    struct stat st;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int worker_count = (cpus > MAX_PARSE_WORKERS) ? MAX_PARSE_WORKERS : (int)cpus;
+    if (worker_count < 2 || fstat(batch_fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size < PARALLEL_BATCH_MIN_BYTES) {
+        return false;
+    }
+
+    // Private writable mapping: lines are tokenized in place, and each process only changes its own copy
+    char* file = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, batch_fd, 0);
+    if (file == MAP_FAILED) return false;
+    madvise(file, (size_t)st.st_size, MADV_SEQUENTIAL);
+    char* file_end = file + st.st_size;
+
+    for (char* window = file; window < file_end;) {
+        char* window_end = line_boundary(window + BATCH_WINDOW_BYTES < file_end ? window + BATCH_WINDOW_BYTES : file_end, file_end);
+
+        // Cut the window into one chunk per worker and number its lines
+        char* chunk_start[MAX_PARSE_WORKERS + 1];
+        int first_line[MAX_PARSE_WORKERS + 1];
+        long chunk_size = (window_end - window) / worker_count + 1;
+        chunk_start[0] = window;
+        first_line[0] = 0;
+        for (int w = 0; w < worker_count; w++) {
+            char* next = (w == worker_count - 1) ? window_end : chunk_start[w] + chunk_size;
+            chunk_start[w + 1] = line_boundary(next < window_end ? next : window_end, window_end);
+            first_line[w + 1] = first_line[w] + count_lines(chunk_start[w], chunk_start[w + 1]);
+        }
+        int line_count = first_line[worker_count];
+
+        size_t mapped_size = (size_t)line_count * sizeof(BatchLine);
+        BatchLine* lines = mmap(NULL, mapped_size > 0 ? mapped_size : 1, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (lines == MAP_FAILED) {
+            perror("mmap");
+            exit(EXIT_FAILURE);
+        }
+
+        pid_t workers[MAX_PARSE_WORKERS];
+        int registry = members.generation; // The member ids the workers see
+        fflush(stdout); // Workers must not inherit (and print again) unflushed output
+        for (int w = 0; w < worker_count; w++) {
+            stats_flush();
+            workers[w] = fork();
+            if (workers[w] == -1) {
+                perror("fork error");
                 exit(EXIT_FAILURE);
             }
-
-            if (pid == 0) {
-                // Child process (print the booking)
-                close(pipe_fd[1]);
-                printBookings(algorithm, pipe_fd[0]);
-                close(pipe_fd[0]);
-                exit(0);
-            } else {
-                // Parent process (run the scheduling algorithm)
-
-                // Logic for manual algorithms
-                if (strcmp(algorithm, "fcfs") == 0) {
-                    reset_global_variables(true);
-                    close(pipe_fd[0]);
-                    fcfs_schedule_to_pipe(pipe_fd[1]);
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                } else if (strcmp(algorithm, "prio") == 0) {
-                    reset_global_variables(true);
-                    close(pipe_fd[0]);
-                    priority_schedule_to_pipe(pipe_fd[1]);
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                } else if (strcmp(algorithm, "sjf") == 0) {
-                    reset_global_variables(true);
-                    close(pipe_fd[0]);
-                    shortest_job_first_to_pipe(pipe_fd[1]);
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                }  
-                // Logic for running all algorithms
-                else if (strcmp(algorithm, "all") == 0) {
-                    const char* algorithms[] = {"fcfs", "prio", "sjf"};
-                    void (*functions[])(int) = {fcfs_schedule_to_pipe, priority_schedule_to_pipe, shortest_job_first_to_pipe};
-                
-                    // Reset the summary array at the start of the ALL command
-                    memset(summary, 0, sizeof(summary));
-
-                    for (int i = 0; i < 3; i++) {
-                        int pipe_fd[2];
-                        pid_t pid;
-                
-                        // Reset global variables 
-                        reset_global_variables(false);
-                        for (int j = 0; j < MAX_FACILITIES; j++) {
-                            facility_availability[j] = 3;
-                        }
-                
-                        // Initialize a new pipe for each algorithm
-                        if (pipe(pipe_fd) == -1) {
-                            perror("pipe error");
-                            exit(EXIT_FAILURE);
-                        }
-                        pid = fork();
-                        if (pid == -1) {
-                            perror("fork error");
-                            exit(EXIT_FAILURE);
-                        }
-                        if (pid == 0) {
-                            // Print the booking
-                            close(pipe_fd[1]); 
-                            printBookings(algorithms[i], pipe_fd[0]);
-                            close(pipe_fd[0]);
-                            exit(0);
-                        } else {
-                            // Run each functions, "fcfs", "prio", "sjf"};
-                            close(pipe_fd[0]); 
-                            functions[i](pipe_fd[1]); 
-                            close(pipe_fd[1]); 
-                            wait(NULL); 
-                        }
+            if (workers[w] == 0) {
+                BatchLine* line = &lines[first_line[w]];
+                for (char* p = chunk_start[w]; p < chunk_start[w + 1]; line++) {
+                    char* newline = memchr(p, '\n', (size_t)(chunk_start[w + 1] - p));
+                    line->offset = p - file;
+                    line->length = (int)((newline ? newline : chunk_start[w + 1]) - p);
+                    if (newline == NULL) { // Last line of the file without a '\n', no room to terminate it
+                        line->kind = BATCH_LINE_REPLAY;
+                        break;
                     }
-                    generate_performance_report();
+                    *newline = '\0';
+                    line->kind = classify_batch_line(p, line->length, &line->booking);
+                    p = newline + 1;
                 }
+                stats_flush();
+                exit(0);
             }
-        } else {
-            // Validation logic
-            CommandType cmdType = parseCommandType(line);
-            if (cmdType == CMD_INVALID) {
-                printf("Error: Invalid command type\n");
-                continue;
+        }
+        for (int w = 0; w < worker_count; w++) {
+            waitpid(workers[w], NULL, 0);
+        }
+
+        // Merge in file order
+        reserve_bookings(booking_count + line_count);
+        for (int i = 0; i < line_count; i++) {
+            BatchLine* line = &lines[i];
+            if (line->kind == BATCH_LINE_BOOKING) {
+                // A new member is registered in file order. After a replayed loadSnapshot restarted the
+                // registry, the workers' ids are stale and every later booking is looked up by name again.
+                if (line->booking.member < 0 || members.generation != registry) {
+                    line->booking.member = intern_member(line->booking.text.client);
+                }
+                if (wal.fd != -1) wal_append_booking(&line->booking);
+                append_booking(&line->booking);
+            } else if (line->kind == BATCH_LINE_REPLAY) {
+                char* text = malloc((size_t)line->length + 1);
+                if (text == NULL) {
+                    perror("malloc");
+                    exit(EXIT_FAILURE);
+                }
+                memcpy(text, file + line->offset, (size_t)line->length);
+                int length = trim_line(text, line->length);
+                if (length > 0) {
+                    process_command(text, length, true);
+                }
+                free(text);
             }
+        }
+
+        munmap(lines, mapped_size > 0 ? mapped_size : 1);
+        window = window_end;
+    }
+
+    munmap(file, (size_t)st.st_size);
+    return true;
+}
 
-            if (!validateCommandFormat(line, cmdType)) {
-                printf("Error: Invalid command format\n");
-                continue;
+void processInput(int input_fd, bool isBatchFile) {
+    LineReader reader;
+    line_reader_init(&reader, input_fd);
+    char* line;
+    int length;
+
+    while (1) {
+        if (!isBatchFile) {
+            printf("Please enter booking:\n");
+        }
+
+        // Input processing, read until white line, trim the whitespace, and skip emtpy lines
+        line = line_reader_next(&reader, &length);
+        if (line == NULL) {
+            break; 
+        }
+
+        length = trim_line(line, length);
+        if (length == 0) {
+            continue;
+        }
+
+        if (!process_command(line, length, isBatchFile)) {
+            break;
+        }
+    }
+
+    line_reader_free(&reader);
+}
+
+// Daemon Functions
+static volatile sig_atomic_t daemon_stopping = 0;
+
+static void daemon_stop(int signal_number) {
+    (void)signal_number;
+    daemon_stopping = 1;
+}
+
+// Bind the listening socket, replacing a stale socket file left by a daemon that did not shut down cleanly
+static int daemon_listen(const char* socket_path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        printf("Error: Socket path is too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        perror("socket");
+        exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    if (stat(socket_path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool in_use = probe != -1 && connect(probe, (struct sockaddr*)&address, sizeof(address)) == 0;
+        if (probe != -1) close(probe);
+        if (in_use) {
+            printf("Error: Another server is already listening on %s\n", socket_path);
+            close(fd);
+            return -1;
+        }
+        unlink(socket_path);
+    }
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) == -1 || listen(fd, SOMAXCONN) == -1) {
+        printf("Error: Cannot listen on socket: %s\n", socket_path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void daemon_close_client(DaemonClient* client) {
+    close(client->fd); // Also takes it out of the epoll set
+    free(client->buffer);
+    free(client);
+}
+
+// Run every complete command line the client has sent so far. The replies go out through stdout, which
+// points at the client meanwhile, so printf and the forked report processes need no changes. False once
+// the client sent endProgram or its request grew too long.
+static bool daemon_run_commands(DaemonClient* client, int saved_stdout) {
+    fflush(stdout);
+    dup2(client->fd, STDOUT_FILENO);
+
+    bool keep_open = true;
+    char* line = client->buffer;
+    char* end = client->buffer + client->used;
+    char* newline;
+    while (keep_open && (newline = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+        *newline = '\0';
+        int length = trim_line(line, (int)(newline - line));
+        if (length > 0) {
+            keep_open = process_command(line, length, false);
+            fputs(DAEMON_END_OF_REPLY, stdout);
+        }
+        line = newline + 1;
+    }
+    if (keep_open && end - line >= DAEMON_MAX_REQUEST) {
+        printf("Error: Command is too long.\n" DAEMON_END_OF_REPLY);
+        keep_open = false;
+    }
+
+    // A client that went away leaves the error flag on stdout, it must not stick to the next one
+    fflush(stdout);
+    clearerr(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+
+    client->used = (int)(end - line);
+    memmove(client->buffer, line, (size_t)client->used);
+    return keep_open;
+}
+
+// Read what the client sent; false when it hung up or should be dropped
+static bool daemon_serve_client(DaemonClient* client, int saved_stdout) {
+    client->buffer = grow_array(client->buffer, &client->capacity, client->used + 4096, 1);
+    ssize_t got = read(client->fd, client->buffer + client->used, (size_t)(client->capacity - client->used));
+    if (got < 0 && (errno == EINTR || errno == EAGAIN)) return true;
+    if (got <= 0) return false;
+    client->used += (int)got;
+    return daemon_run_commands(client, saved_stdout);
+}
+
+static void daemon_accept_clients(int listen_fd, int epoll_fd) {
+    while (1) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd == -1) return; // EAGAIN: no more waiting connections
+        struct timeval timeout = {.tv_sec = DAEMON_SEND_TIMEOUT_SEC};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        DaemonClient* client = calloc(1, sizeof(DaemonClient));
+        if (client == NULL) {
+            perror("calloc");
+            exit(EXIT_FAILURE);
+        }
+        client->fd = fd;
+        struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP, .data.ptr = client};
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            perror("epoll_ctl");
+            daemon_close_client(client);
+        }
+    }
+}
+
+// -socket: serve the command language to any number of clients over a Unix domain socket, all sharing this
+// process's bookings. Commands run one at a time in arrival order, so they see the same table as at the
+// prompt. The write-ahead log's group deadline doubles as the epoll timeout. Stops on SIGINT or SIGTERM.
+bool run_daemon(const char* socket_path) {
+    int listen_fd = daemon_listen(socket_path);
+    if (listen_fd == -1) return false;
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    int saved_stdout = dup(STDOUT_FILENO);
+    if (epoll_fd == -1 || saved_stdout == -1) {
+        perror("epoll_create1");
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) == -1) {
+        perror("epoll_ctl");
+        exit(EXIT_FAILURE);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = daemon_stop; // No SA_RESTART, epoll_wait has to return
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN); // A client hanging up mid-reply is an ordinary write error
+
+    printf("Serving on %s\n", socket_path);
+    fflush(stdout);
+
+    struct epoll_event events[DAEMON_MAX_EVENTS];
+    while (!daemon_stopping) {
+        int ready = epoll_wait(epoll_fd, events, DAEMON_MAX_EVENTS, wal_idle());
+        if (ready == -1 && errno != EINTR) {
+            perror("epoll_wait");
+            exit(EXIT_FAILURE);
+        }
+        if (ready == 0) {
+            wal_sync(); // Quiet until the group's deadline
+        }
+        for (int i = 0; i < ready; i++) {
+            DaemonClient* client = events[i].data.ptr;
+            if (client == NULL) {
+                daemon_accept_clients(listen_fd, epoll_fd);
+            } else if (!daemon_serve_client(client, saved_stdout)) {
+                daemon_close_client(client);
             }
-            processBooking(line);
         }
     }
+
+    printf("->Bye!\n");
+    close(epoll_fd);
+    close(listen_fd);
+    close(saved_stdout);
+    unlink(socket_path);
+    return true;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // SPMS_G40 [site.cfg] [-wal bookings.wal] [-socket spms.sock]
+    const char* site_path = NULL;
+    const char* wal_path = NULL;
+    const char* socket_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-wal") == 0 && i + 1 < argc) {
+            wal_path = argv[++i];
+        } else if (strcmp(argv[i], "-socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else {
+            site_path = argv[i];
+        }
+    }
+
+    // Site configuration: explicit path, else site_G40.cfg if present, else the built-in site
+    if (site_path != NULL) {
+        if (!load_site_config(site_path)) return EXIT_FAILURE;
+    } else if (access(DEFAULT_SITE_CONFIG, R_OK) == 0) {
+        if (!load_site_config(DEFAULT_SITE_CONFIG)) return EXIT_FAILURE;
+    } else {
+        load_default_site();
+    }
+
+    stats_init();
+    init_members();
     printf("~~ Welcome to PolyU Smart Parking Management System ~~\n");
 
-    // Start the user input
-    processInput(stdin, false);
+    // Bookings from earlier runs come back before any new input
+    if (wal_path != NULL && !wal_open(wal_path)) return EXIT_FAILURE;
+
+    // Start the user input, from the prompt or from socket clients
+    bool ok = true;
+    if (socket_path != NULL) {
+        ok = run_daemon(socket_path);
+    } else {
+        processInput(STDIN_FILENO, false);
+    }
+    wal_close();
 
-    return 0;
+    return ok ? 0 : EXIT_FAILURE;
 }
 
 // addBatch -correct_testing.dat;
@@ -0,0 +1,271 @@
+// Benchmark driver for SPMS_G40. For every workload size it generates a seeded batch file with workload_G40,
+// then runs the benchmark build of SPMS on it once per algorithm and run. Every phase the program measures
+// (parse, schedule, ipc, report) and the wall time of the whole run become one CSV row on stdout.
+//
+//   gcc -std=c99 -O2 -DBENCHMARK SPMS_G40.c -o SPMS_bench
+//   gcc -std=c99 workload_G40.c -o workload_G40
+//   gcc -std=c99 benchmark_G40.c -o benchmark_G40
+//   ./benchmark_G40 -sizes 1000,10000,100000 -runs 3 > results.csv
+#define _GNU_SOURCE // clock_gettime under -std=c99
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <time.h>
+
+// Constants
+#define MAX_SIZES 32
+#define MAX_ALGORITHMS 4
+#define MAX_NAME_LEN 50
+#define MAX_PATH_LEN 256
+#define DEFAULT_SPMS "./SPMS_bench"
+#define DEFAULT_WORKLOAD "./workload_G40"
+#define DEFAULT_SIZES "1000,10000,100000"
+#define DEFAULT_ALGORITHMS "fcfs,prio,sjf,all"
+
+// Structures
+typedef struct {
+    const char* spms;
+    const char* workload;
+    const char* site;      // Optional site configuration passed on to SPMS
+    const char* seed;
+    const char* distribution;
+    const char* days;
+    long sizes[MAX_SIZES];
+    int size_count;
+    char algorithms[MAX_ALGORITHMS][MAX_NAME_LEN];
+    int algorithm_count;
+    int runs;
+    bool keep;             // Keep the generated batch files
+} BenchmarkOptions;
+
+// Function Prototypes
+bool parse_options(int argc, char* argv[], BenchmarkOptions* options);
+double now_ms();
+bool generate_workload(const BenchmarkOptions* options, long size, const char* path);
+char* run_spms(const BenchmarkOptions* options, const char* commands, double* wall_ms);
+void print_rows(const BenchmarkOptions* options, long size, const char* algorithm, int run, const char* output, double wall_ms);
+
+// Utility Functions
+double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+bool parse_options(int argc, char* argv[], BenchmarkOptions* options) {
+    const char* sizes = DEFAULT_SIZES;
+    const char* algorithms = DEFAULT_ALGORITHMS;
+
+    options->spms = DEFAULT_SPMS;
+    options->workload = DEFAULT_WORKLOAD;
+    options->site = NULL;
+    options->seed = "1";
+    options->distribution = "uniform";
+    options->days = "30";
+    options->runs = 1;
+    options->keep = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-keep") == 0) {
+            options->keep = true;
+            continue;
+        }
+
+        const char* value = (i + 1 < argc) ? argv[++i] : NULL;
+        if (value == NULL) {
+            fprintf(stderr, "Error: Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        if (strcmp(argv[i - 1], "-spms") == 0) options->spms = value;
+        else if (strcmp(argv[i - 1], "-workload") == 0) options->workload = value;
+        else if (strcmp(argv[i - 1], "-site") == 0) options->site = value;
+        else if (strcmp(argv[i - 1], "-seed") == 0) options->seed = value;
+        else if (strcmp(argv[i - 1], "-dist") == 0) options->distribution = value;
+        else if (strcmp(argv[i - 1], "-days") == 0) options->days = value;
+        else if (strcmp(argv[i - 1], "-runs") == 0) options->runs = atoi(value);
+        else if (strcmp(argv[i - 1], "-sizes") == 0) sizes = value;
+        else if (strcmp(argv[i - 1], "-algorithms") == 0) algorithms = value;
+        else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i - 1]);
+            return false;
+        }
+    }
+
+    // Comma separated lists
+    char list[MAX_PATH_LEN];
+    options->size_count = 0;
+    snprintf(list, sizeof(list), "%s", sizes);
+    for (char* item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+        if (options->size_count >= MAX_SIZES || atol(item) <= 0) {
+            fprintf(stderr, "Error: Invalid size list '%s'\n", sizes);
+            return false;
+        }
+        options->sizes[options->size_count++] = atol(item);
+    }
+
+    options->algorithm_count = 0;
+    snprintf(list, sizeof(list), "%s", algorithms);
+    for (char* item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+        if (options->algorithm_count >= MAX_ALGORITHMS ||
+            (strcmp(item, "fcfs") != 0 && strcmp(item, "prio") != 0 && strcmp(item, "sjf") != 0 && strcmp(item, "all") != 0)) {
+            fprintf(stderr, "Error: Invalid algorithm list '%s'. Use fcfs, prio, sjf and all.\n", algorithms);
+            return false;
+        }
+        strcpy(options->algorithms[options->algorithm_count++], item);
+    }
+
+    if (options->runs <= 0 || options->size_count == 0 || options->algorithm_count == 0) {
+        fprintf(stderr, "Error: Need at least one size, one algorithm and one run\n");
+        return false;
+    }
+    return true;
+}
+
+// Process Functions
+// Run workload_G40 with its stdout going to path
+bool generate_workload(const BenchmarkOptions* options, long size, const char* path) {
+    char count[32];
+    snprintf(count, sizeof(count), "%ld", size);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork error");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) {
+            perror("open");
+            exit(EXIT_FAILURE);
+        }
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+        execl(options->workload, options->workload, "-n", count, "-seed", options->seed,
+              "-dist", options->distribution, "-days", options->days, (char*)NULL);
+        perror("exec workload");
+        exit(EXIT_FAILURE);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Feed commands to one SPMS run (report thrown away) and return everything it wrote to stderr; caller frees it
+char* run_spms(const BenchmarkOptions* options, const char* commands, double* wall_ms) {
+    int in_fd[2], err_fd[2];
+    if (pipe(in_fd) == -1 || pipe(err_fd) == -1) {
+        perror("pipe error");
+        exit(EXIT_FAILURE);
+    }
+
+    double started = now_ms();
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork error");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(in_fd[0], STDIN_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(err_fd[1], STDERR_FILENO);
+        close(in_fd[0]);
+        close(in_fd[1]);
+        close(err_fd[0]);
+        close(err_fd[1]);
+        close(null_fd);
+        execl(options->spms, options->spms, options->site, (char*)NULL);
+        perror("exec spms");
+        exit(EXIT_FAILURE);
+    }
+
+    close(in_fd[0]);
+    close(err_fd[1]);
+    if (write(in_fd[1], commands, strlen(commands)) != (ssize_t)strlen(commands)) {
+        perror("write");
+    }
+    close(in_fd[1]);
+
+    // Collect stderr until every process of the run has closed it
+    size_t capacity = 4096, used = 0;
+    char* output = malloc(capacity);
+    ssize_t n;
+    while (output != NULL && (n = read(err_fd[0], output + used, capacity - used - 1)) > 0) {
+        used += (size_t)n;
+        if (used + 1 == capacity) {
+            capacity *= 2;
+            output = realloc(output, capacity);
+        }
+    }
+    if (output == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    output[used] = '\0';
+    close(err_fd[0]);
+
+    waitpid(pid, NULL, 0);
+    *wall_ms = now_ms() - started;
+    return output;
+}
+
+// CSV: bookings,seed,distribution,command,run,phase,algorithm,ms
+void print_rows(const BenchmarkOptions* options, long size, const char* algorithm, int run, const char* output, double wall_ms) {
+    const char* line = output;
+    while (*line) {
+        char phase[MAX_NAME_LEN], phase_algorithm[MAX_NAME_LEN];
+        int bookings;
+        double ms;
+        if (sscanf(line, "BENCH phase=%49s algorithm=%49s bookings=%d ms=%lf", phase, phase_algorithm, &bookings, &ms) == 4) {
+            printf("%ld,%s,%s,%s,%d,%s,%s,%.3f\n", size, options->seed, options->distribution, algorithm, run,
+                   phase, phase_algorithm, ms);
+        }
+        const char* newline = strchr(line, '\n');
+        if (newline == NULL) break;
+        line = newline + 1;
+    }
+    printf("%ld,%s,%s,%s,%d,total,%s,%.3f\n", size, options->seed, options->distribution, algorithm, run, algorithm, wall_ms);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!parse_options(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [-sizes n,n,...] [-algorithms fcfs,prio,sjf,all] [-runs n] [-seed n] "
+                        "[-dist uniform|peak] [-days n] [-spms path] [-workload path] [-site cfg] [-keep]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("bookings,seed,distribution,command,run,phase,algorithm,ms\n");
+    for (int s = 0; s < options.size_count; s++) {
+        char path[MAX_PATH_LEN];
+        snprintf(path, sizeof(path), "bench_G40_%ld_%s.dat", options.sizes[s], options.seed);
+        if (!generate_workload(&options, options.sizes[s], path)) {
+            fprintf(stderr, "Error: Cannot generate workload with %s\n", options.workload);
+            return EXIT_FAILURE;
+        }
+
+        for (int a = 0; a < options.algorithm_count; a++) {
+            char commands[2 * MAX_PATH_LEN];
+            snprintf(commands, sizeof(commands), "addBatch -%s;\nprintBookings -%s;\nendProgram;\n", path, options.algorithms[a]);
+            for (int run = 1; run <= options.runs; run++) {
+                double wall_ms;
+                char* output = run_spms(&options, commands, &wall_ms);
+                print_rows(&options, options.sizes[s], options.algorithms[a], run, output, wall_ms);
+                free(output);
+            }
+        }
+
+        if (!options.keep) {
+            unlink(path);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,237 @@
+// Synthetic workload generator for SPMS_G40: prints a batch file of valid booking commands to stdout.
+// The same seed and options always give the same file, so benchmark runs can be compared over time.
+//
+//   gcc -std=c99 workload_G40.c -o workload_G40
+//   ./workload_G40 -n 100000 -seed 42 -days 30 -dist peak > bench.dat
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Constants
+#define NUM_OF_MEMBER 5
+#define NUM_FACILITIES 6
+#define NUM_TYPES 4
+#define MINUTES_PER_DAY 1440
+#define DEFAULT_BOOKINGS 10000
+#define DEFAULT_SEED 1
+#define DEFAULT_DAYS 30
+#define DEFAULT_START_DATE "2025-05-01"
+
+// Enums
+typedef enum {
+    DIST_UNIFORM, // Start times spread evenly over the day
+    DIST_PEAK     // Most bookings start around the 08:00-10:00 and 17:00-19:00 rush hours
+} StartDistribution;
+
+// Structures
+typedef struct {
+    long count;
+    uint64_t seed;
+    int days;
+    int start_day; // Days since 1970-01-01
+    StartDistribution distribution;
+    int type_weights[NUM_TYPES]; // addParking, addReservation, addEvent, bookEssentials
+    double invalid_rate;         // Share of lines with a deliberately malformed field
+} WorkloadOptions;
+
+// Global Variables
+const char* type_names[NUM_TYPES] = {"addParking", "addReservation", "addEvent", "bookEssentials"};
+const char* facility_names[NUM_FACILITIES] = {"battery", "cable", "umbrella", "locker", "valetpark", "inflation"};
+uint64_t rng_state;
+
+// Function Prototypes
+uint64_t next_random();
+int random_below(int bound);
+double random_unit();
+int days_from_civil(int y, int m, int d);
+void civil_from_days(int days, int* y, int* m, int* d);
+bool parse_options(int argc, char* argv[], WorkloadOptions* options);
+int pick_start_minute(StartDistribution distribution);
+void write_booking(FILE* out, const WorkloadOptions* options);
+
+// Random Functions
+// splitmix64: small, fast and the same on every platform (rand() is not)
+uint64_t next_random() {
+    uint64_t z = (rng_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+int random_below(int bound) {
+    return (int)(next_random() % (uint64_t)bound);
+}
+
+// Uniform in [0, 1)
+double random_unit() {
+    return (double)(next_random() >> 11) / 9007199254740992.0;
+}
+
+// Date Functions (proleptic Gregorian, days since 1970-01-01)
+int days_from_civil(int y, int m, int d) {
+    y -= (m <= 2);
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void civil_from_days(int days, int* y, int* m, int* d) {
+    days += 719468;
+    int era = days / 146097;
+    int doe = days - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = yoe + era * 400 + (*m <= 2);
+}
+
+// Option Functions
+bool parse_options(int argc, char* argv[], WorkloadOptions* options) {
+    int y, m, d;
+    sscanf(DEFAULT_START_DATE, "%d-%d-%d", &y, &m, &d);
+
+    options->count = DEFAULT_BOOKINGS;
+    options->seed = DEFAULT_SEED;
+    options->days = DEFAULT_DAYS;
+    options->start_day = days_from_civil(y, m, d);
+    options->distribution = DIST_UNIFORM;
+    options->type_weights[0] = 4;
+    options->type_weights[1] = 3;
+    options->type_weights[2] = 2;
+    options->type_weights[3] = 1;
+    options->invalid_rate = 0.0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            fprintf(stderr, "Error: Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        if (strcmp(argv[i], "-n") == 0) {
+            options->count = atol(value);
+        } else if (strcmp(argv[i], "-seed") == 0) {
+            options->seed = strtoull(value, NULL, 10);
+        } else if (strcmp(argv[i], "-days") == 0) {
+            options->days = atoi(value);
+        } else if (strcmp(argv[i], "-start") == 0) {
+            if (sscanf(value, "%d-%d-%d", &y, &m, &d) != 3 || y < 1970 || m < 1 || m > 12 || d < 1 || d > 31) {
+                fprintf(stderr, "Error: Invalid start date %s, expected YYYY-MM-DD\n", value);
+                return false;
+            }
+            options->start_day = days_from_civil(y, m, d);
+        } else if (strcmp(argv[i], "-dist") == 0) {
+            if (strcmp(value, "uniform") == 0) {
+                options->distribution = DIST_UNIFORM;
+            } else if (strcmp(value, "peak") == 0) {
+                options->distribution = DIST_PEAK;
+            } else {
+                fprintf(stderr, "Error: Invalid distribution '%s'. Must be 'uniform' or 'peak'.\n", value);
+                return false;
+            }
+        } else if (strcmp(argv[i], "-mix") == 0) {
+            int *w = options->type_weights;
+            if (sscanf(value, "%d:%d:%d:%d", &w[0], &w[1], &w[2], &w[3]) != 4 ||
+                w[0] < 0 || w[1] < 0 || w[2] < 0 || w[3] < 0 || w[0] + w[1] + w[2] + w[3] == 0) {
+                fprintf(stderr, "Error: Invalid mix '%s', expected parking:reservation:event:essentials weights\n", value);
+                return false;
+            }
+        } else if (strcmp(argv[i], "-invalid") == 0) {
+            options->invalid_rate = atof(value);
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            return false;
+        }
+        i++;
+    }
+
+    if (options->count < 0 || options->days <= 0 || options->invalid_rate < 0.0 || options->invalid_rate > 1.0) {
+        fprintf(stderr, "Error: -n must be >= 0, -days > 0 and -invalid between 0 and 1\n");
+        return false;
+    }
+    return true;
+}
+
+// Workload Functions
+// Minute of the day a booking starts, on a 15 minute grid
+int pick_start_minute(StartDistribution distribution) {
+    if (distribution == DIST_PEAK && random_unit() < 0.7) {
+        // Sum of three uniforms is a cheap bell curve, centred on one of the two rush hours
+        int centre = (random_below(2) == 0) ? 9 * 60 : 18 * 60;
+        int offset = (int)((random_unit() + random_unit() + random_unit() - 1.5) * 120.0);
+        int minute = centre + offset;
+        if (minute < 0) minute = 0;
+        if (minute >= MINUTES_PER_DAY) minute = MINUTES_PER_DAY - 1;
+        return minute - minute % 15;
+    }
+    return random_below(MINUTES_PER_DAY / 15) * 15;
+}
+
+void write_booking(FILE* out, const WorkloadOptions* options) {
+    // Command type by weight
+    int total = 0;
+    for (int i = 0; i < NUM_TYPES; i++) total += options->type_weights[i];
+    int pick = random_below(total);
+    int type = 0;
+    while (pick >= options->type_weights[type]) {
+        pick -= options->type_weights[type];
+        type++;
+    }
+
+    int y, m, d;
+    civil_from_days(options->start_day + random_below(options->days), &y, &m, &d);
+    int start = pick_start_minute(options->distribution);
+    int half_hours = 1 + random_below(12); // 0.5 to 6.0 hours
+
+    // addEvent books three facilities, bookEssentials one, parking and reservations up to two
+    int facility_count = (type == 2) ? 3 : (type == 3) ? 1 : random_below(3);
+    int chosen[NUM_FACILITIES];
+    for (int i = 0; i < NUM_FACILITIES; i++) chosen[i] = i;
+    for (int i = 0; i < facility_count; i++) { // Partial Fisher-Yates, no facility twice
+        int j = i + random_below(NUM_FACILITIES - i);
+        int swap = chosen[i];
+        chosen[i] = chosen[j];
+        chosen[j] = swap;
+    }
+
+    bool invalid = options->invalid_rate > 0.0 && random_unit() < options->invalid_rate;
+    int broken_field = invalid ? random_below(3) : -1;
+
+    fprintf(out, "%s -member_%c ", type_names[type], 'A' + random_below(NUM_OF_MEMBER));
+    if (broken_field == 0) {
+        fprintf(out, "%04d-13-%02d ", y, d); // Month out of range
+    } else {
+        fprintf(out, "%04d-%02d-%02d ", y, m, d);
+    }
+    if (broken_field == 1) {
+        fprintf(out, "%02d:75 ", start / 60); // Minute out of range
+    } else {
+        fprintf(out, "%02d:%02d ", start / 60, start % 60);
+    }
+    fprintf(out, "%.1f", half_hours * 0.5);
+    for (int i = 0; i < facility_count; i++) {
+        fprintf(out, " %s", facility_names[chosen[i]]);
+    }
+    fprintf(out, (broken_field == 2) ? "\n" : ";\n"); // Missing semicolon
+}
+
+int main(int argc, char* argv[]) {
+    WorkloadOptions options;
+    if (!parse_options(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [-n count] [-seed n] [-days n] [-start YYYY-MM-DD] [-dist uniform|peak] "
+               "[-mix p:r:e:s] [-invalid rate]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    rng_state = options.seed;
+    for (long i = 0; i < options.count; i++) {
+        write_booking(stdout, &options);
+    }
+    return 0;
+}